@@ -62,7 +62,7 @@
 #define configQUEUE_REGISTRY_SIZE				0
 #define configUSE_RECURSIVE_MUTEXES				1
 #define configUSE_MALLOC_FAILED_HOOK			1
-#define configUSE_APPLICATION_TASK_TAG			0
+#define configUSE_APPLICATION_TASK_TAG			1
 #define configUSE_COUNTING_SEMAPHORES			1
 #define configGENERATE_RUN_TIME_STATS			0
 
@@ -94,6 +94,17 @@ to exclude the API function. */
 #ifndef __LANGUAGE_ASSEMBLY
 	void vAssertCalled( const char *pcFileName, unsigned long ulLine );
 	#define configASSERT( x ) if( ( x ) == 0 ) vAssertCalled( __FILE__, __LINE__ )
+
+	/* TMAN tags each managed task with its TMAN task and uses the context
+	switch hooks to exclude preemptions from job execution times. The
+	switch-out hook also gets whether the task is still in its ready list:
+	a preemption, not a block of its own (delay, queue, semaphore). Both
+	expand inside tasks.c, where pxReadyTasksLists is in scope. */
+	void vTMAN_TaskSwitchedIn( void *pvTag );
+	void vTMAN_TaskSwitchedOut( void *pvTag, long lStillReady );
+	#define traceTASK_SWITCHED_IN()		vTMAN_TaskSwitchedIn( ( void * ) pxCurrentTCB->pxTaskTag )
+	#define traceTASK_SWITCHED_OUT()	vTMAN_TaskSwitchedOut( ( void * ) pxCurrentTCB->pxTaskTag, \
+			( long ) listIS_CONTAINED_WITHIN( &pxReadyTasksLists[ pxCurrentTCB->uxPriority ], &pxCurrentTCB->xStateListItem ) )
 #endif
 
 /* The priority at which the tick interrupt runs.  This should probably be
@@ -0,0 +1,27 @@
+/* 
+ * File:   uart.c
+ * Author: André Alves
+ * Author: Eduardo Coelho
+ *
+ * Target: host (FreeRTOS POSIX port)
+ * 
+ * Overview:
+ *          UART stub for the hosted build, the console is stdout.
+ * 
+ */
+
+#include <stdio.h>
+
+#include "uart.h"
+
+
+int UartInit(uint64_t pbclock, uint32_t br) {
+    (void) pbclock;
+    (void) br;
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    return UART_SUCCESS;
+}
+
+void PrintStr(const char *str) {
+    fputs(str, stdout);
+}
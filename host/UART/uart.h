@@ -0,0 +1,27 @@
+/* 
+ * File:   uart.h
+ * Author: André Alves
+ * Author: Eduardo Coelho
+ *
+ * Target: host (FreeRTOS POSIX port)
+ * 
+ * Overview:
+ *          Stand-in for the PIC32 UART driver: PrintStr() writes to
+ *          stdout. Found by tman.c as "../UART/uart.h" through the
+ *          host/include directory.
+ * 
+ */
+
+#ifndef UART_H
+#define	UART_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define UART_SUCCESS    0
+#define UART_FAIL       -1
+
+int UartInit(uint64_t pbclock, uint32_t br);
+void PrintStr(const char *str);
+
+#endif	/* UART_H */
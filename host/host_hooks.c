@@ -0,0 +1,35 @@
+/* 
+ * File:   host_hooks.c
+ * Author: André Alves
+ * Author: Eduardo Coelho
+ *
+ * Target: host (FreeRTOS POSIX port)
+ * 
+ * Overview:
+ *          Kernel hooks required by host/include/FreeRTOSConfig.h.
+ * 
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+
+void vAssertCalled(const char *pcFileName, unsigned long ulLine) {
+    fprintf(stderr, "ASSERT: %s:%lu\n", pcFileName, ulLine);
+    abort();
+}
+
+void vApplicationMallocFailedHook(void) {
+    fprintf(stderr, "malloc failed\n");
+    abort();
+}
+
+unsigned long ulHostRunTimeCounter(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long) ts.tv_sec * 1000000UL + ts.tv_nsec / 1000;
+}
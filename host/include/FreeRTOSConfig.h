@@ -0,0 +1,85 @@
+/*
+ * FreeRTOS configuration for the hosted TMAN build (FreeRTOS POSIX port).
+ * Mirrors ../../FreeRTOSConfig.h where the port allows it: same tick
+ * rate, priorities and TMAN hooks. Stacks back pthreads, hence larger.
+ *
+ * See http://www.freertos.org/a00110.html
+ */
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+#define configUSE_PREEMPTION					1
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION	0
+#define configUSE_IDLE_HOOK						0
+#define configUSE_TICK_HOOK						0
+#define configTICK_RATE_HZ						( ( TickType_t ) 1000 )
+#define configCPU_CLOCK_HZ						( 80000000UL )
+#define configPERIPHERAL_CLOCK_HZ				( 40000000UL )
+#define configMAX_PRIORITIES					( 32UL )
+#define configMINIMAL_STACK_SIZE				( 4096 )
+#define configTOTAL_HEAP_SIZE					( ( size_t ) ( 1024 * 1024 ) )
+#define configMAX_TASK_NAME_LEN					( 16 )
+#define configUSE_TRACE_FACILITY				1
+#define configUSE_16_BIT_TICKS					0
+#define configIDLE_SHOULD_YIELD					1
+#define configUSE_MUTEXES						1
+#define configCHECK_FOR_STACK_OVERFLOW			0
+#define configQUEUE_REGISTRY_SIZE				0
+#define configUSE_RECURSIVE_MUTEXES				1
+#define configUSE_MALLOC_FAILED_HOOK			1
+#define configUSE_APPLICATION_TASK_TAG			1
+#define configUSE_COUNTING_SEMAPHORES			1
+#define configUSE_TASK_NOTIFICATIONS			1
+
+/* Run time stats give the CPU time of the TMAN dispatcher to tman_bench */
+#define configGENERATE_RUN_TIME_STATS			1
+
+/* Co-routine definitions. */
+#define configUSE_CO_ROUTINES 			0
+#define configMAX_CO_ROUTINE_PRIORITIES ( 2 )
+
+/* Software timer definitions. */
+#define configUSE_TIMERS				1
+#define configTIMER_TASK_PRIORITY		( 2 )
+#define configTIMER_QUEUE_LENGTH		5
+#define configTIMER_TASK_STACK_DEPTH	( configMINIMAL_STACK_SIZE * 2 )
+
+/* Set the following definitions to 1 to include the API function, or zero
+to exclude the API function. */
+
+#define INCLUDE_vTaskPrioritySet			1
+#define INCLUDE_uxTaskPriorityGet			1
+#define INCLUDE_vTaskDelete					1
+#define INCLUDE_vTaskCleanUpResources		0
+#define INCLUDE_vTaskSuspend				1
+#define INCLUDE_vTaskDelayUntil				1
+#define INCLUDE_vTaskDelay					1
+#define INCLUDE_uxTaskGetStackHighWaterMark	1
+#define INCLUDE_eTaskGetState				1
+#define INCLUDE_xTaskGetHandle              1
+#define INCLUDE_xTaskGetCurrentTaskHandle	1
+
+/* Prevent C specific syntax being included in assembly files. */
+#ifndef __LANGUAGE_ASSEMBLY
+	void vAssertCalled( const char *pcFileName, unsigned long ulLine );
+	#define configASSERT( x ) if( ( x ) == 0 ) vAssertCalled( __FILE__, __LINE__ )
+
+	/* Microsecond counter from the host monotonic clock (host_hooks.c) */
+	unsigned long ulHostRunTimeCounter( void );
+	#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+	#define portGET_RUN_TIME_COUNTER_VALUE()	ulHostRunTimeCounter()
+
+	/* TMAN tags each managed task with its TMAN task and uses the context
+	switch hooks to exclude preemptions from job execution times. The
+	switch-out hook also gets whether the task is still in its ready list:
+	a preemption, not a block of its own (delay, queue, semaphore). Both
+	expand inside tasks.c, where pxReadyTasksLists is in scope. */
+	void vTMAN_TaskSwitchedIn( void *pvTag );
+	void vTMAN_TaskSwitchedOut( void *pvTag, long lStillReady );
+	#define traceTASK_SWITCHED_IN()		vTMAN_TaskSwitchedIn( ( void * ) pxCurrentTCB->pxTaskTag )
+	#define traceTASK_SWITCHED_OUT()	vTMAN_TaskSwitchedOut( ( void * ) pxCurrentTCB->pxTaskTag, \
+			( long ) listIS_CONTAINED_WITHIN( &pxReadyTasksLists[ pxCurrentTCB->uxPriority ], &pxCurrentTCB->xStateListItem ) )
+#endif
+
+#endif /* FREERTOS_CONFIG_H */
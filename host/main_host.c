@@ -0,0 +1,91 @@
+/*
+ * File:   main_host.c
+ * Author: André Alves
+ * Author: Eduardo Coelho
+ *
+ * Port of main_tman.c to the FreeRTOS POSIX port
+ * - Same six tasks, periods, phases and precedence (B after F), from
+ *   the same compile-time task set table
+ * - UART output goes to stdout
+ * - TMAN ends the scheduler after TMAN_SELFTEST_TICKS ticks
+ *
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <string.h>
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "tman.h"
+
+
+/* App includes */
+#include "../UART/uart.h"
+
+
+/* Set the tasks' period (in system ticks) */
+#define PERIOD_200MS             (  200 / portTICK_RATE_MS ) // 
+
+/* Priorities of the demo application tasks (high numb. -> high prio.) */
+#define PRIORITY_A        ( tskIDLE_PRIORITY +  4 )
+#define PRIORITY_B        ( tskIDLE_PRIORITY +  4 )
+#define PRIORITY_C        ( tskIDLE_PRIORITY +  3 )
+#define PRIORITY_D        ( tskIDLE_PRIORITY +  3 )
+#define PRIORITY_E        ( tskIDLE_PRIORITY +  2 )
+#define PRIORITY_F        ( tskIDLE_PRIORITY +  2 )
+
+void taskBody( void * pvParameters ) {
+    tman_handle_t task = (tman_handle_t) pvParameters;
+    
+    for (;;) {
+        // Wait for the next cycle.
+        TMAN_TaskWaitPeriodEx(task);
+        
+        int tcks = xTaskGetTickCount();
+        
+        // Formatted and printed later by the TMAN console task
+        TMAN_Log("%s, %d\n\r", TMAN_TaskGetName(task), tcks);
+        
+        volatile int i, j, k;
+        for (i = 0; i < 36; i++)
+            for (j = 0; j < 36; j++)
+                k = i*j;
+    }
+}
+
+// Task, Body, Priority, Period, Phase, Deadline, WCET (us, 0 = unknown), Dependency
+#define DEMO_TASKS(X, s) \
+    X(s, A, taskBody, PRIORITY_A, 1, 0, 1, 0, NONE) \
+    X(s, B, taskBody, PRIORITY_B, 1, 0, 1, 0, F)    \
+    X(s, C, taskBody, PRIORITY_C, 3, 0, 3, 0, NONE) \
+    X(s, D, taskBody, PRIORITY_D, 3, 1, 3, 0, NONE) \
+    X(s, E, taskBody, PRIORITY_E, 4, 0, 4, 0, NONE) \
+    X(s, F, taskBody, PRIORITY_F, 4, 2, 4, 0, NONE)
+
+TMAN_TASK_SET(demo, DEMO_TASKS, PERIOD_200MS);
+
+int main( void ) {
+
+    UartInit(configPERIPHERAL_CLOCK_HZ, 115200);
+
+    printf("\n\n*********************************************\n\r");
+    printf("\nTask Management framework for FreeRTOS (host)\n\r");
+    printf("\n\n*********************************************\n\r");
+
+    // Priorities come from the registered periods, PRIORITY_A..F only
+    // apply until the dispatcher starts
+    TMAN_InitMode(PERIOD_200MS, TMAN_MODE_ASSIGN_RM);
+
+    if (TMAN_TaskSetLoad(demo, demo_COUNT, NULL) != TMAN_SUCCESS) {
+        printf("Invalid Attribute\nExiting\n");
+        return -1;
+    }
+
+    /* Returns when TMAN ends the scheduler */
+    vTaskStartScheduler();
+
+    return 0;
+}
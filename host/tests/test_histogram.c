@@ -0,0 +1,169 @@
+/*
+ * File:   test_histogram.c
+ * Author: André Alves
+ * Author: Eduardo Coelho
+ *
+ * Target: host (plain C, no FreeRTOS)
+ *
+ * Overview:
+ *          Accuracy of TMAN_HistogramQuantile() against the exact
+ *          nearest-rank quantiles of host-generated traces:
+ *          - uniform, exponential, bimodal and heavy-tailed traces
+ *            short enough to never saturate a bucket: every quantile
+ *            within 1/2^(TMAN_HIST_SUB_BITS+1) of the exact one
+ *          - long stationary traces that saturate buckets and halve
+ *            the counts many times: same bound against the quantiles
+ *            of the whole trace
+ *          - a shift of the distribution after saturation: the
+ *            halving lets the recent samples take over
+ *
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "tman_histogram.h"
+
+
+#define SHORT_SAMPLES       50000
+#define LONG_SAMPLES        2000000
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            exit(1); \
+        } \
+    } while (0)
+
+static const uint32_t quantiles[] = { 100, 1000, 5000, 9000, 9900, 9990 };
+#define NUM_QUANTILES (sizeof(quantiles) / sizeof(quantiles[0]))
+
+static uint64_t rng = 0x9e3779b97f4a7c15ULL;
+static uint32_t *trace;
+
+static double prvUniform(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return ((rng >> 11) + 0.5) / (double) (1ULL << 53);
+}
+
+typedef uint32_t (*sample_fn)(void);
+
+static uint32_t prvSampleUniform(void) {
+    return 1 + (uint32_t) (prvUniform() * 20000);
+}
+
+// Response-time like: offset plus exponential tail, mean 800 us
+static uint32_t prvSampleExponential(void) {
+    return 200 + (uint32_t) (-800 * log(prvUniform()));
+}
+
+// Two operating points, 97% fast jobs
+static uint32_t prvSampleBimodal(void) {
+    if (prvUniform() < 0.97)
+        return 400 + (uint32_t) (prvUniform() * 50);
+    return 15000 + (uint32_t) (prvUniform() * 3000);
+}
+
+// Pareto, alpha 1.5, capped below 2^TMAN_HIST_MAX_BITS
+static uint32_t prvSampleHeavy(void) {
+    double v = 100 / pow(prvUniform(), 1 / 1.5);
+    return v < (1 << TMAN_HIST_MAX_BITS) - 1 ? (uint32_t) v : (1 << TMAN_HIST_MAX_BITS) - 1;
+}
+
+static int prvCompare(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *) a, y = *(const uint32_t *) b;
+    return x < y ? -1 : x > y;
+}
+
+/* Nearest rank, as TMAN_HistogramQuantile() counts it */
+static uint32_t prvExact(const uint32_t *sorted, uint32_t n, uint32_t basis_points) {
+    uint32_t rank = ((uint64_t) n * basis_points + 9999) / 10000;
+    return sorted[(rank > 0 ? rank : 1) - 1];
+}
+
+/* Every quantile of hist within the bucket error of the exact one */
+static void prvCheckAccuracy(const char *name, const tman_histogram *hist, uint32_t *samples, uint32_t n) {
+    double worst = 0;
+
+    qsort(samples, n, sizeof(*samples), prvCompare);
+    for (unsigned q = 0; q < NUM_QUANTILES; q++) {
+        uint32_t exact = prvExact(samples, n, quantiles[q]);
+        uint32_t estimate = TMAN_HistogramQuantile(hist, quantiles[q]);
+        double error = fabs((double) estimate - exact) / exact;
+
+        if (error > 1.0 / (2 << TMAN_HIST_SUB_BITS)) {
+            fprintf(stderr, "%s p%.2f: exact %u, estimate %u\n", name, quantiles[q] / 100.0, exact, estimate);
+            exit(1);
+        }
+        if (error > worst)
+            worst = error;
+    }
+    printf("%-12s %8u samples, total %6u, worst error %.2f%%\n", name, n, hist->TOTAL, 100 * worst);
+}
+
+static void prvTrace(const char *name, sample_fn sample, uint32_t n) {
+    tman_histogram hist;
+
+    memset(&hist, 0, sizeof(hist));
+    for (uint32_t k = 0; k < n; k++) {
+        trace[k] = sample();
+        TMAN_HistogramAdd(&hist, trace[k]);
+    }
+
+    // Counts never wrap, TOTAL stays their sum
+    uint32_t sum = 0;
+    for (int i = 0; i < TMAN_HIST_BUCKETS; i++)
+        sum += hist.COUNT[i];
+    CHECK(sum == hist.TOTAL);
+    if (n > UINT16_MAX)
+        CHECK(hist.TOTAL < n);
+
+    prvCheckAccuracy(name, &hist, trace, n);
+}
+
+/* After saturation the counts of the old distribution are halved with
+ * every new saturation, the new one takes over the quantiles */
+static void prvShift(void) {
+    tman_histogram hist;
+
+    memset(&hist, 0, sizeof(hist));
+    for (uint32_t k = 0; k < 4 * UINT16_MAX; k++)
+        TMAN_HistogramAdd(&hist, 300);
+    CHECK(TMAN_HistogramQuantile(&hist, 9990) == TMAN_HistogramQuantile(&hist, 5000));
+
+    for (uint32_t k = 0; k < 4 * UINT16_MAX; k++)
+        TMAN_HistogramAdd(&hist, 6000);
+    uint32_t p50 = TMAN_HistogramQuantile(&hist, 5000);
+    CHECK(fabs((double) p50 - 6000) / 6000 <= 1.0 / (2 << TMAN_HIST_SUB_BITS));
+    // The old samples are down to a few percent of the total
+    uint32_t p5 = TMAN_HistogramQuantile(&hist, 500);
+    CHECK(fabs((double) p5 - 6000) / 6000 <= 1.0 / (2 << TMAN_HIST_SUB_BITS));
+    printf("%-12s p5 %u, p50 %u after the shift from 300 to 6000\n", "shift", p5, p50);
+}
+
+int main(void) {
+
+    trace = malloc(LONG_SAMPLES * sizeof(*trace));
+    CHECK(trace != NULL);
+
+    prvTrace("uniform", prvSampleUniform, SHORT_SAMPLES);
+    prvTrace("exponential", prvSampleExponential, SHORT_SAMPLES);
+    prvTrace("bimodal", prvSampleBimodal, SHORT_SAMPLES);
+    prvTrace("heavy", prvSampleHeavy, SHORT_SAMPLES);
+
+    // Saturate and halve
+    prvTrace("uniform/L", prvSampleUniform, LONG_SAMPLES);
+    prvTrace("exponential/L", prvSampleExponential, LONG_SAMPLES);
+    prvTrace("bimodal/L", prvSampleBimodal, LONG_SAMPLES);
+    prvTrace("heavy/L", prvSampleHeavy, LONG_SAMPLES);
+
+    prvShift();
+
+    free(trace);
+    return 0;
+}
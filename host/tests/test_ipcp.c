@@ -0,0 +1,174 @@
+/*
+ * File:   test_ipcp.c
+ * Author: André Alves
+ * Author: Eduardo Coelho
+ *
+ * Target: host (FreeRTOS POSIX port)
+ *
+ * Overview:
+ *          Immediate priority ceiling protocol through the real
+ *          TMAN_ResourceLock()/TMAN_ResourceUnlock() path. A high task
+ *          locks two resources, each shared with one of two lower tasks
+ *          that hold them for long critical sections. A critical
+ *          section of a lower task that ends while a high job is
+ *          pending is one blocking of that job: under the protocol
+ *          every high job is blocked at most once. Blocked jobs must
+ *          occur, or the test did not exercise anything. Misses are
+ *          only reported, host stalls can outlast the high period.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "tman.h"
+
+
+#define TEST_TICKS          3000
+
+#define PRIORITY_LOW        ( tskIDLE_PRIORITY + 2 )
+#define PRIORITY_MEDIUM     ( tskIDLE_PRIORITY + 3 )
+#define PRIORITY_HIGH       ( tskIDLE_PRIORITY + 4 )
+#define PRIORITY_CONTROL    ( TMAN_PRIORITY + 1 )
+
+// Critical sections and the work between them, in microseconds
+#define HIGH_CS_US          200
+#define MEDIUM_CS_US        1500
+#define LOW_CS_US           2500
+#define GAP_US              500
+#define SECTIONS            3
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            exit(1); \
+        } \
+    } while (0)
+
+static tman_handle_t high, medium, low;
+static tman_resource_t r1, r2;
+
+// Lower critical sections ended while a high job was pending
+static volatile uint32_t blockings;
+static uint32_t high_jobs;
+static uint32_t blocked_jobs;
+static uint32_t worst_blockings;
+
+/* Thread CPU time: preemptions do not count against the work */
+static void prvSpin(uint32_t us) {
+    struct timespec ts;
+    uint64_t start, now;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    start = (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    do {
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        now = (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    } while (now - start < (uint64_t) us * 1000);
+}
+
+static void prvSection(tman_handle_t task, tman_resource_t resource, uint32_t us) {
+    CHECK(TMAN_ResourceLock(task, resource) == TMAN_SUCCESS);
+    prvSpin(us);
+    // Released and not completed: the high job waits on this section
+    if (task != high && high->OUTSTANDING > 0)
+        blockings++;
+    CHECK(TMAN_ResourceUnlock(task, resource) == TMAN_SUCCESS);
+}
+
+static void prvHigh(void *pvParam) {
+    (void) pvParam;
+
+    for (;;) {
+        TMAN_TaskWaitPeriodEx(high);
+        prvSection(high, r1, HIGH_CS_US);
+        prvSection(high, r2, HIGH_CS_US);
+
+        // Nothing below runs until this job completes
+        uint32_t b = blockings;
+        blockings = 0;
+        high_jobs++;
+        if (b > 0)
+            blocked_jobs++;
+        if (b > worst_blockings)
+            worst_blockings = b;
+    }
+}
+
+static void prvMedium(void *pvParam) {
+    (void) pvParam;
+
+    for (;;) {
+        TMAN_TaskWaitPeriodEx(medium);
+        for (int k = 0; k < SECTIONS; k++) {
+            prvSection(medium, r2, MEDIUM_CS_US);
+            prvSpin(GAP_US);
+        }
+    }
+}
+
+static void prvLow(void *pvParam) {
+    (void) pvParam;
+
+    for (;;) {
+        TMAN_TaskWaitPeriodEx(low);
+        for (int k = 0; k < SECTIONS; k++) {
+            prvSection(low, r1, LOW_CS_US);
+            prvSpin(GAP_US);
+        }
+    }
+}
+
+static void prvControl(void *pvParam) {
+    (void) pvParam;
+    tman_stats_t stats;
+
+    vTaskDelay(TEST_TICKS);
+
+    CHECK(TMAN_TaskStatsEx(high, &stats) == TMAN_SUCCESS);
+    printf("ipcp: %u high jobs, %u blocked, at most %u blocking per job, %lu misses, "
+           "bound %lu us, contentions %lu/%lu\n", high_jobs, blocked_jobs, worst_blockings,
+           (unsigned long) stats.DEADLINE_MISSES, (unsigned long) TMAN_TaskGetBlocking(high),
+           (unsigned long) r1->CONTENTIONS, (unsigned long) r2->CONTENTIONS);
+
+    CHECK(high_jobs > 0);
+    CHECK(blocked_jobs > 0);
+    CHECK(worst_blockings <= 1);
+    CHECK(TMAN_TaskGetBlocking(high) >= LOW_CS_US);
+    exit(0);
+}
+
+int main(void) {
+
+    TMAN_Init(1);
+
+    // Kernel tasks first, so the ceilings see their priorities
+    xTaskCreate(prvHigh, "H", configMINIMAL_STACK_SIZE, NULL, PRIORITY_HIGH, NULL);
+    xTaskCreate(prvMedium, "M", configMINIMAL_STACK_SIZE, NULL, PRIORITY_MEDIUM, NULL);
+    xTaskCreate(prvLow, "L", configMINIMAL_STACK_SIZE, NULL, PRIORITY_LOW, NULL);
+
+    high = TMAN_TaskAdd("H");
+    medium = TMAN_TaskAdd("M");
+    low = TMAN_TaskAdd("L");
+    CHECK(high != NULL && medium != NULL && low != NULL);
+    CHECK(TMAN_TaskRegisterAttributesEx(high, "PERIOD", "20") == TMAN_SUCCESS);
+    CHECK(TMAN_TaskRegisterAttributesEx(medium, "PERIOD", "30") == TMAN_SUCCESS);
+    CHECK(TMAN_TaskRegisterAttributesEx(low, "PERIOD", "50") == TMAN_SUCCESS);
+
+    r1 = TMAN_ResourceDeclare(high, "R1", HIGH_CS_US);
+    CHECK(TMAN_ResourceDeclare(low, "R1", LOW_CS_US) == r1);
+    r2 = TMAN_ResourceDeclare(high, "R2", HIGH_CS_US);
+    CHECK(TMAN_ResourceDeclare(medium, "R2", MEDIUM_CS_US) == r2);
+    CHECK(r1 != NULL && r2 != NULL && r1 != r2);
+    CHECK(r1->CEILING == PRIORITY_HIGH && r2->CEILING == PRIORITY_HIGH);
+
+    xTaskCreate(prvControl, "CTRL", configMINIMAL_STACK_SIZE, NULL, PRIORITY_CONTROL, NULL);
+
+    vTaskStartScheduler();
+
+    return 1;
+}
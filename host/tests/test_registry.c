@@ -0,0 +1,174 @@
+/*
+ * File:   test_registry.c
+ * Author: André Alves
+ * Author: Eduardo Coelho
+ *
+ * Target: host (FreeRTOS POSIX port), TMAN_MAX_TASKS=512
+ *
+ * Overview:
+ *          Task registry stress test. Fills all TMAN_MAX_TASKS slots,
+ *          checks the overflow, duplicate names and the reuse of
+ *          removed slots, then
+ *          churns 504 periodic fillers with random removes, adds,
+ *          pauses and resumes while the dispatcher releases them. Eight
+ *          probe tasks stay registered throughout and must keep their
+ *          period without a miss.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "tman.h"
+
+
+#define PROBES              8
+#define PROBE_PERIOD        20      // ticks, well above host scheduling hiccups
+#define FILLERS             ( TMAN_MAX_TASKS - PROBES )
+#define CHURN_TICKS         500
+#define CHURN_PER_TICK      16
+
+#define PRIORITY_CHURN      ( tskIDLE_PRIORITY + 1 )
+#define PRIORITY_PROBE      ( tskIDLE_PRIORITY + 2 )
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            exit(1); \
+        } \
+    } while (0)
+
+static char names[TMAN_MAX_TASKS][8];
+static tman_handle_t fillers[FILLERS];
+static tman_handle_t probes[PROBES];
+static unsigned long churned;
+
+static void prvProbe(void *pvParam) {
+    tman_handle_t task = (tman_handle_t) pvParam;
+
+    for (;;)
+        TMAN_TaskWaitPeriodEx(task);
+}
+
+/* Filler k under a fresh name, period 1..16 ticks, no kernel task:
+ * the dispatcher releases it and drops the release */
+static tman_handle_t prvFillerAdd(int k) {
+    static unsigned generation;
+    char period[4];
+
+    sprintf(names[k], "F%x", generation++ & 0xffffff);
+    tman_handle_t task = TMAN_TaskAdd(names[k]);
+    CHECK(task != NULL);
+    sprintf(period, "%d", 1 + rand() % 16);
+    CHECK(TMAN_TaskRegisterAttributesEx(task, "PERIOD", period) == TMAN_SUCCESS);
+    return task;
+}
+
+/* Slots: overflow, removal, reuse (before the scheduler starts) */
+static void prvRegistryChecks(void) {
+    static tman_handle_t all[TMAN_MAX_TASKS];
+
+    for (int k = 0; k < TMAN_MAX_TASKS; k++) {
+        sprintf(names[k], "S%d", k);
+        all[k] = TMAN_TaskAdd(names[k]);
+        CHECK(all[k] != NULL);
+        for (int j = 0; j < k; j++)
+            CHECK(all[j] != all[k]);
+    }
+    CHECK(TMAN_TaskAdd("OVER") == NULL);
+
+    for (int k = 1; k < TMAN_MAX_TASKS; k += 2)
+        CHECK(TMAN_TaskRemove(all[k]) == TMAN_SUCCESS);
+    CHECK(TMAN_TaskRemove(all[1]) == TMAN_FAIL_TASK_NOT_ADDED);
+    CHECK(TMAN_TaskGetHandle("S1") == NULL);
+    CHECK(TMAN_TaskGetHandle("S2") == all[2]);
+
+    // Free slots, but the name is taken; a removed name is free again
+    CHECK(TMAN_TaskAdd("S2") == NULL);
+    tman_handle_t again = TMAN_TaskAdd("S1");
+    CHECK(again != NULL);
+    CHECK(TMAN_TaskRemove(again) == TMAN_SUCCESS);
+
+    // Every new task lands in a freed slot
+    for (int k = 1; k < TMAN_MAX_TASKS; k += 2) {
+        sprintf(names[k], "R%d", k);
+        tman_handle_t task = TMAN_TaskAdd(names[k]);
+        int reused = 0;
+        for (int j = 1; j < TMAN_MAX_TASKS; j += 2)
+            reused |= task == all[j];
+        CHECK(reused);
+    }
+    CHECK(TMAN_TaskAdd("OVER") == NULL);
+
+    for (int k = 0; k < TMAN_MAX_TASKS; k++)
+        CHECK(TMAN_TaskRemove(all[k]) == TMAN_SUCCESS);
+}
+
+/* Churns the fillers while the dispatcher runs, then checks the probes */
+static void prvChurn(void *pvParam) {
+    (void) pvParam;
+    tman_stats_t stats;
+
+    TickType_t start = xTaskGetTickCount();
+    while (xTaskGetTickCount() - start < CHURN_TICKS) {
+        for (int n = 0; n < CHURN_PER_TICK; n++) {
+            int k = rand() % FILLERS;
+            switch (rand() % 4) {
+                case 0:
+                    CHECK(TMAN_TaskPause(fillers[k]) == TMAN_SUCCESS);
+                    break;
+                case 1:
+                    CHECK(TMAN_TaskResume(fillers[k]) == TMAN_SUCCESS);
+                    break;
+                default:
+                    CHECK(TMAN_TaskRemove(fillers[k]) == TMAN_SUCCESS);
+                    fillers[k] = prvFillerAdd(PROBES + k);
+                    churned++;
+                    break;
+            }
+        }
+        vTaskDelay(1);
+    }
+    TickType_t ticks = xTaskGetTickCount() - start;
+
+    for (int k = 0; k < PROBES; k++) {
+        CHECK(TMAN_TaskStatsEx(probes[k], &stats) == TMAN_SUCCESS);
+        CHECK(stats.DEADLINE_MISSES == 0);
+        CHECK(stats.ACTIVATIONS + 2 >= ticks / PROBE_PERIOD);
+    }
+    // Slots are all taken again
+    CHECK(TMAN_TaskAdd("OVER") == NULL);
+
+    printf("registry: %d slots, %lu removes/adds over %lu ticks, probes on time\n",
+           TMAN_MAX_TASKS, churned, (unsigned long) ticks);
+    exit(0);
+}
+
+int main(void) {
+
+    srand(1);
+    TMAN_Init(1);
+
+    prvRegistryChecks();
+
+    char period[4];
+    sprintf(period, "%d", PROBE_PERIOD);
+    for (int k = 0; k < PROBES; k++) {
+        sprintf(names[k], "P%d", k);
+        probes[k] = TMAN_TaskAdd(names[k]);
+        CHECK(probes[k] != NULL);
+        xTaskCreate(prvProbe, names[k], configMINIMAL_STACK_SIZE, (void *) probes[k], PRIORITY_PROBE, NULL);
+        TMAN_TaskRegisterAttributesEx(probes[k], "PERIOD", period);
+    }
+    for (int k = 0; k < FILLERS; k++)
+        fillers[k] = prvFillerAdd(PROBES + k);
+
+    xTaskCreate(prvChurn, "CHURN", configMINIMAL_STACK_SIZE, NULL, PRIORITY_CHURN, NULL);
+
+    vTaskStartScheduler();
+
+    return 1;
+}
@@ -0,0 +1,204 @@
+/*
+ * File:   test_seqlock.c
+ * Author: André Alves
+ * Author: Eduardo Coelho
+ *
+ * Target: host (FreeRTOS POSIX port)
+ *
+ * Overview:
+ *          Lock-free stats readers hammered against their writers. Four
+ *          tasks run a job of random length every tick (JOB_SEQ, and
+ *          RELEASE_SEQ from the dispatcher). A reader below them, which
+ *          they preempt mid-copy, and a reader above them, which
+ *          preempts them like an ISR would, read TMAN_TaskStatsEx(),
+ *          TMAN_TaskGetExecTime() and TMAN_TaskGetResponseQuantile() in
+ *          a loop. Every snapshot must be consistent: at most one job
+ *          between activations and completions, min <= avg <= max, and
+ *          no counter going back. The same checks on plain unlocked
+ *          reads are only counted, to show the test does interleave.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "tman.h"
+
+
+#define WRITERS             4
+#define TEST_TICKS          3000
+#define HIGH_BURST_NS       200000
+
+#define PRIORITY_LOW        ( tskIDLE_PRIORITY + 1 )
+#define PRIORITY_WRITER     ( tskIDLE_PRIORITY + 2 )
+#define PRIORITY_HIGH       ( tskIDLE_PRIORITY + 3 )
+#define PRIORITY_CONTROL    ( TMAN_PRIORITY + 1 )
+
+typedef struct reader {
+    const char *NAME;
+    tman_stats_t LAST[WRITERS];
+    uint32_t SNAPSHOTS;
+    uint32_t BUSY;              // TMAN_FAIL: writer mid-update on every attempt
+    uint32_t EXEC_READS;
+    uint32_t QUANTILE_READS;
+    uint32_t TORN;              // inconsistent unlocked reads
+    uint32_t ROUND;
+} reader;
+
+static tman_handle_t writers[WRITERS];
+static reader low = { "low" };
+static reader high = { "high" };
+static volatile uint32_t violations;
+
+static uint32_t prvNowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t) ((uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+static void prvViolation(reader *r, int w, const char *what) {
+    fprintf(stderr, "%s reader, W%d: %s\n", r->NAME, w, what);
+    violations++;
+}
+
+static void prvWriter(void *pvParam) {
+    tman_handle_t task = (tman_handle_t) pvParam;
+    uint32_t seed = (uintptr_t) task;
+
+    for (;;) {
+        TMAN_TaskWaitPeriodEx(task);
+        seed = seed * 1103515245 + 12345;
+        uint32_t length = 20000 + (seed >> 8) % 180000;
+        uint32_t start = prvNowNs();
+        while (prvNowNs() - start < length)
+            ;
+    }
+}
+
+/* The checks of a snapshot, also run on unlocked copies */
+static int prvConsistent(const tman_stats_t *s) {
+    if (s->COMPLETED_JOBS > s->ACTIVATIONS || s->ACTIVATIONS > s->COMPLETED_JOBS + 1)
+        return 0;
+    if (s->COMPLETED_JOBS > 0 && (s->EXEC_MIN > s->EXEC_AVG || s->EXEC_AVG > s->EXEC_MAX))
+        return 0;
+    if (s->COMPLETED_JOBS > 0 && (s->RESPONSE_MIN > s->RESPONSE_AVG || s->RESPONSE_AVG > s->RESPONSE_MAX))
+        return 0;
+    return 1;
+}
+
+/* Unlocked copy of the fields prvConsistent() looks at */
+static void prvUnlockedCopy(tman_handle_t task, tman_stats_t *s) {
+    uint32_t jobs;
+
+    s->ACTIVATIONS = task->NUM_ACTIVATIONS;
+    s->COMPLETED_JOBS = jobs = task->EXEC_COUNT;
+    s->EXEC_MIN = task->EXEC_MIN / 1000;
+    s->EXEC_MAX = task->EXEC_MAX / 1000;
+    s->EXEC_AVG = jobs ? task->EXEC_SUM / jobs / 1000 : 0;
+    s->RESPONSE_MIN = task->RESPONSE_MIN / 1000;
+    s->RESPONSE_MAX = task->RESPONSE_MAX / 1000;
+    s->RESPONSE_AVG = jobs ? task->RESPONSE_SUM / jobs / 1000 : 0;
+}
+
+static void prvRead(reader *r, int w) {
+    tman_stats_t s;
+    uint32_t min, max, mean, p99;
+
+    if (TMAN_TaskStatsEx(writers[w], &s) != TMAN_SUCCESS) {
+        r->BUSY++;
+    } else {
+        tman_stats_t *last = &r->LAST[w];
+        if (!prvConsistent(&s))
+            prvViolation(r, w, "inconsistent snapshot");
+        if (s.ACTIVATIONS < last->ACTIVATIONS || s.COMPLETED_JOBS < last->COMPLETED_JOBS
+                || s.DEADLINE_MISSES < last->DEADLINE_MISSES || s.QUEUED_RELEASES < last->QUEUED_RELEASES
+                || s.DROPPED_RELEASES < last->DROPPED_RELEASES || s.PREEMPTIONS < last->PREEMPTIONS)
+            prvViolation(r, w, "counter went back");
+        *last = s;
+        r->SNAPSHOTS++;
+    }
+
+    // The quantile walks the whole histogram: every few reads only, so
+    // most preemptions still land in a snapshot copy
+    if (++r->ROUND % 16 == 0) {
+        if (TMAN_TaskGetExecTime(writers[w], &min, &max, &mean) == TMAN_SUCCESS) {
+            if (min > mean || mean > max)
+                prvViolation(r, w, "exec time min/mean/max out of order");
+            r->EXEC_READS++;
+        }
+        if (TMAN_TaskGetResponseQuantile(writers[w], 9900, &p99) == TMAN_SUCCESS)
+            r->QUANTILE_READS++;
+    }
+
+    prvUnlockedCopy(writers[w], &s);
+    if (!prvConsistent(&s))
+        r->TORN++;
+}
+
+/* Preempted by the writers at every tick */
+static void prvLowReader(void *pvParam) {
+    (void) pvParam;
+
+    for (int w = 0;; w = (w + 1) % WRITERS)
+        prvRead(&low, w);
+}
+
+/* Preempts the writers for a burst of reads every tick */
+static void prvHighReader(void *pvParam) {
+    (void) pvParam;
+
+    for (;;) {
+        uint32_t start = prvNowNs();
+        for (int w = 0; prvNowNs() - start < HIGH_BURST_NS; w = (w + 1) % WRITERS)
+            prvRead(&high, w);
+        vTaskDelay(1);
+    }
+}
+
+static void prvReport(const reader *r) {
+    printf("%s reader: %u snapshots, %u busy, %u exec times, %u quantiles, %u torn unlocked reads\n",
+           r->NAME, r->SNAPSHOTS, r->BUSY, r->EXEC_READS, r->QUANTILE_READS, r->TORN);
+}
+
+static void prvControl(void *pvParam) {
+    (void) pvParam;
+
+    vTaskDelay(TEST_TICKS);
+
+    prvReport(&low);
+    prvReport(&high);
+    if (violations > 0 || low.SNAPSHOTS == 0 || high.SNAPSHOTS == 0
+            || low.EXEC_READS == 0 || low.QUANTILE_READS == 0) {
+        fprintf(stderr, "FAILED: %u violations\n", violations);
+        exit(1);
+    }
+    exit(0);
+}
+
+int main(void) {
+    static char names[WRITERS][8];
+
+    // One TMAN tick per kernel tick
+    TMAN_Init(1);
+
+    for (int w = 0; w < WRITERS; w++) {
+        sprintf(names[w], "W%d", w);
+        writers[w] = TMAN_TaskAdd(names[w]);
+        xTaskCreate(prvWriter, names[w], configMINIMAL_STACK_SIZE, (void *) writers[w], PRIORITY_WRITER, NULL);
+        TMAN_TaskRegisterAttributesEx(writers[w], "PERIOD", "1");
+        TMAN_TaskRegisterAttributesEx(writers[w], "BACKLOG", "2");
+    }
+
+    xTaskCreate(prvLowReader, "RLOW", configMINIMAL_STACK_SIZE, NULL, PRIORITY_LOW, NULL);
+    xTaskCreate(prvHighReader, "RHIGH", configMINIMAL_STACK_SIZE, NULL, PRIORITY_HIGH, NULL);
+    xTaskCreate(prvControl, "CTRL", configMINIMAL_STACK_SIZE, NULL, PRIORITY_CONTROL, NULL);
+
+    vTaskStartScheduler();
+
+    return 1;
+}
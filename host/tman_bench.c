@@ -0,0 +1,241 @@
+/*
+ * File:   tman_bench.c
+ * Author: André Alves
+ * Author: Eduardo Coelho
+ *
+ * Target: host (FreeRTOS POSIX port)
+ *   tman_bench [-j] <load tasks> [ticks]
+ *
+ * Overview:
+ *          TMAN overhead micro-benchmarks. Runs <load tasks> empty
+ *          periodic tasks (period 1 tick), or run-to-completion jobs
+ *          (TMAN_JobAdd()) with -j, next to four probes and prints one
+ *          CSV row, times in microseconds:
+ *          - dispatch: CPU time of the TMAN task per tick
+ *          - release: release-to-run latency of the highest priority
+ *            probe (TMAN start latency stats)
+ *          - waitperiod: TMAN_TaskWaitPeriodEx() round trip when the
+ *            next release is already queued (no blocking)
+ *          - handoff: predecessor completion to dependent start
+ *          - load: CPU time of the load per tick (its tasks, or the
+ *            executor), and the RAM it takes besides the TMAN slots
+ *            (stacks and TCBs)
+ *          The last column tells the load model apart. The sweep over
+ *          task counts is the bench_sweep CMake target, bench_sweep_jobs
+ *          for -j, bench_jobs_vs_tasks for both side by side, and
+ *          bench_activation against the suspend/resume activation path
+ *          (tman_bench_suspend, TMAN_ACTIVATION_SUSPEND=1).
+ *          Host timings include the POSIX port's thread switches, use
+ *          them to compare TMAN revisions, not as PIC32 figures.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "tman.h"
+
+
+// Last column: how the load is activated
+#if TMAN_ACTIVATION_SUSPEND
+#define MODEL_TASKS         "suspend"
+#else
+#define MODEL_TASKS         "tasks"
+#endif
+
+#define PRIORITY_LOAD       ( tskIDLE_PRIORITY + 1 )
+#define PRIORITY_WAIT       ( tskIDLE_PRIORITY + 1 )
+#define PRIORITY_PRODUCER   ( tskIDLE_PRIORITY + 2 )
+#define PRIORITY_CONSUMER   ( tskIDLE_PRIORITY + 3 )
+#define PRIORITY_RELEASE    ( tskIDLE_PRIORITY + 4 )
+#define PRIORITY_CONTROL    ( TMAN_PRIORITY + 1 )
+
+// Releases the round trip probe lets pile up before it drains them
+#define WAIT_BACKLOG        4
+
+typedef struct bench_acc {
+    uint64_t SUM;
+    uint32_t MAX;
+    uint32_t COUNT;
+} bench_acc;
+
+static int bench_ticks = 2000;
+static int bench_load = 0;
+static int bench_jobs = 0;
+static tman_handle_t probe_release;
+
+static volatile uint32_t producer_done;
+static bench_acc handoff;
+static bench_acc round_trip;
+
+static uint32_t prvNowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t) ((uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+static void prvAccAdd(bench_acc *acc, uint32_t ns) {
+    acc->SUM += ns;
+    if (ns > acc->MAX)
+        acc->MAX = ns;
+    acc->COUNT++;
+}
+
+static double prvAccAvgUs(const bench_acc *acc) {
+    return acc->COUNT ? acc->SUM / 1000.0 / acc->COUNT : 0;
+}
+
+/* Load and release probe: empty jobs */
+static void prvEmptyJob(void *pvParam) {
+    tman_handle_t task = (tman_handle_t) pvParam;
+
+    for (;;)
+        TMAN_TaskWaitPeriodEx(task);
+}
+
+/* Load job: returns right away */
+static void prvEmptyFn(void *arg) {
+    (void) arg;
+}
+
+/* Predecessor of the handoff pair: stamps its completion */
+static void prvProducer(void *pvParam) {
+    tman_handle_t task = (tman_handle_t) pvParam;
+
+    for (;;) {
+        producer_done = prvNowNs();
+        TMAN_TaskWaitPeriodEx(task);
+    }
+}
+
+/* Dependent of the handoff pair, above the producer: it already waits on
+ * the join when the producer completes */
+static void prvConsumer(void *pvParam) {
+    tman_handle_t task = (tman_handle_t) pvParam;
+
+    TMAN_TaskWaitPeriodEx(task);
+    for (;;) {
+        TMAN_TaskWaitPeriodEx(task);
+        prvAccAdd(&handoff, prvNowNs() - producer_done);
+    }
+}
+
+/* Sleeps through a few releases, then times the calls that find their
+ * release already queued */
+static void prvWaitProbe(void *pvParam) {
+    tman_handle_t task = (tman_handle_t) pvParam;
+
+    TMAN_TaskWaitPeriodEx(task);
+    for (;;) {
+        vTaskDelay(WAIT_BACKLOG);
+        for (int k = 0; k < WAIT_BACKLOG; k++) {
+            // Notification value: releases queued for this task
+            int queued = ulTaskNotifyValueClear(NULL, 0) > 0;
+            uint32_t start = prvNowNs();
+            TMAN_TaskWaitPeriodEx(task);
+            if (queued)
+                prvAccAdd(&round_trip, prvNowNs() - start);
+        }
+    }
+}
+
+/* Lets the probes run for bench_ticks, then reports and exits */
+static void prvControl(void *pvParam) {
+    static TaskStatus_t status[TMAN_MAX_TASKS + 16];
+    uint32_t total;
+    unsigned long dispatch = 0;
+    unsigned long load = 0;
+    tman_stats_t stats;
+
+    vTaskDelay(bench_ticks);
+
+    int n = uxTaskGetSystemState(status, sizeof(status) / sizeof(status[0]), &total);
+    for (int k = 0; k < n; k++) {
+        if (status[k].xHandle == xTaskGetHandle("TMAN"))
+            dispatch = status[k].ulRunTimeCounter;
+        if (status[k].pcTaskName[0] == 'L' || strcmp(status[k].pcTaskName, "TMANX0") == 0)
+            load += status[k].ulRunTimeCounter;
+    }
+
+    // Tasks: a stack and a TCB each. Jobs: one executor shared by all.
+    size_t ram = sizeof(StaticTask_t) + (bench_jobs ? TMAN_EXECUTOR_STACK : configMINIMAL_STACK_SIZE) * sizeof(StackType_t);
+    if (!bench_jobs)
+        ram *= bench_load;
+    else if (bench_load == 0)
+        ram = 0;
+
+    if (TMAN_TaskStatsEx(probe_release, &stats) != TMAN_SUCCESS)
+        stats.START_LATENCY_AVG = stats.START_LATENCY_MAX = 0;
+
+    printf("%d,%.2f,%lu,%lu,%.2f,%.2f,%.2f,%.2f,%.2f,%lu,%s\n", bench_load,
+           (double) dispatch / bench_ticks,
+           (unsigned long) stats.START_LATENCY_AVG, (unsigned long) stats.START_LATENCY_MAX,
+           prvAccAvgUs(&round_trip), round_trip.MAX / 1000.0,
+           prvAccAvgUs(&handoff), handoff.MAX / 1000.0,
+           (double) load / bench_ticks, (unsigned long) ram, bench_jobs ? "jobs" : MODEL_TASKS);
+    fflush(stdout);
+    exit(0);
+}
+
+static tman_handle_t prvAddProbe(char *name, TaskFunction_t body, UBaseType_t priority) {
+    tman_handle_t task = body != NULL ? TMAN_TaskAdd(name) : TMAN_JobAdd(name, prvEmptyFn, NULL);
+
+    if (task == NULL) {
+        fprintf(stderr, "TMAN_MAX_TASKS too small for %d load tasks\n", bench_load);
+        exit(1);
+    }
+    if (body != NULL)
+        xTaskCreate(body, name, configMINIMAL_STACK_SIZE, (void *) task, priority, NULL);
+    TMAN_TaskRegisterAttributesEx(task, "PERIOD", "1");
+    return task;
+}
+
+int main(int argc, char *argv[]) {
+    static char names[TMAN_MAX_TASKS][8];
+    int arg = 1;
+
+    if (argc > 1 && strcmp(argv[1], "-j") == 0) {
+        bench_jobs = 1;
+        arg++;
+    }
+    if (argc - arg < 1 || argc - arg > 2) {
+        fprintf(stderr, "usage: %s [-j] <load tasks> [ticks]\n", argv[0]);
+        return 1;
+    }
+    bench_load = atoi(argv[arg]);
+    if (argc - arg == 2)
+        bench_ticks = atoi(argv[arg + 1]);
+    if (bench_load < 0 || bench_load + 4 > TMAN_MAX_TASKS || bench_ticks <= 0) {
+        fprintf(stderr, "load tasks must be 0..%d\n", TMAN_MAX_TASKS - 4);
+        return 1;
+    }
+
+    // One TMAN tick per kernel tick
+    TMAN_Init(1);
+
+    for (int k = 0; k < bench_load; k++) {
+        sprintf(names[k], "L%d", k);
+        // Jobs run on the executor of band 0, at PRIORITY_LOAD
+        prvAddProbe(names[k], bench_jobs ? NULL : prvEmptyJob, PRIORITY_LOAD);
+    }
+
+    probe_release = prvAddProbe("REL", prvEmptyJob, PRIORITY_RELEASE);
+
+    tman_handle_t wait = prvAddProbe("WAIT", prvWaitProbe, PRIORITY_WAIT);
+    TMAN_TaskSetBacklog(wait, TMAN_BACKLOG_QUEUE, WAIT_BACKLOG + 2);
+
+    tman_handle_t producer = prvAddProbe("PRED", prvProducer, PRIORITY_PRODUCER);
+    tman_handle_t consumer = prvAddProbe("DEP", prvConsumer, PRIORITY_CONSUMER);
+    TMAN_TaskAddPrecedence(consumer, producer);
+
+    xTaskCreate(prvControl, "CTRL", configMINIMAL_STACK_SIZE, NULL, PRIORITY_CONTROL, NULL);
+
+    vTaskStartScheduler();
+
+    return 1;
+}
@@ -0,0 +1,157 @@
+/*
+ * File:   tman_edf.c
+ * Author: André Alves
+ * Author: Eduardo Coelho
+ *
+ * Target: host (FreeRTOS POSIX port)
+ *   tman_edf <fp|edf> <utilization %> <seed> [ticks]
+ *
+ * Overview:
+ *          Deadline misses of fixed priority against EDF on one random
+ *          task set, one CSV row:
+ *          - SET_TASKS periodic tasks, implicit deadlines, periods
+ *            uniform in PERIOD_MIN..PERIOD_MAX TMAN ticks of TICK_MS,
+ *            over [ticks] TMAN ticks (default 5000), utilizations
+ *            drawn with UUniFast to sum up to <utilization>
+ *          - each job spins for its share of thread CPU time, so the
+ *            preemptions it suffers do not count against it
+ *          - OVERRUN SKIP: a host stall that makes a job late costs its
+ *            task one release instead of piling up a backlog, under
+ *            EDF late jobs would otherwise hold the earliest deadline
+ *            and make every task late (the domino effect)
+ *          - fp: TMAN_MODE_ASSIGN_RM, one priority level per task
+ *          - edf: TMAN_MODE_EDF
+ *          The same seed gives the same set under both policies. The
+ *          bench_edf CMake target sweeps the utilization over
+ *          TMAN_EDF_SETS seeds. The host adds the dispatcher and the
+ *          port's thread switches to every set, compare the policies
+ *          with each other, not with the nominal utilization.
+ *
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "tman.h"
+
+
+// One level per task under fixed priority, see TMAN_AssignPriorities()
+#define SET_TASKS           ( TMAN_PRIORITY - 1 - tskIDLE_PRIORITY )
+#define PERIOD_MIN          20
+#define PERIOD_MAX          200
+// TMAN tick: periods of 40..400 ms keep the host's scheduling stalls of
+// a few ms small against the slack of a job
+#define TICK_MS             2
+
+#define PRIORITY_TASK       ( tskIDLE_PRIORITY + 1 )
+#define PRIORITY_CONTROL    ( TMAN_PRIORITY + 1 )
+
+static int bench_ticks = 5000;
+static int bench_edf = 0;
+static int bench_util = 90;
+static unsigned bench_seed = 1;
+
+static tman_handle_t tasks[SET_TASKS];
+static uint32_t work_ns[SET_TASKS];
+
+static uint64_t prvThreadNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void prvTask(void *pvParam) {
+    int k = (intptr_t) pvParam;
+
+    for (;;) {
+        TMAN_TaskWaitPeriodEx(tasks[k]);
+        uint64_t start = prvThreadNs();
+        while (prvThreadNs() - start < work_ns[k])
+            ;
+    }
+}
+
+static double prvUniform(void) {
+    return (rand() + 0.5) / ((double) RAND_MAX + 1);
+}
+
+/* UUniFast: SET_TASKS utilizations summing up to total */
+static void prvUUniFast(double total, double *u) {
+    double sum = total;
+
+    for (int k = 0; k < SET_TASKS - 1; k++) {
+        double next = sum * pow(prvUniform(), 1.0 / (SET_TASKS - 1 - k));
+        u[k] = sum - next;
+        sum = next;
+    }
+    u[SET_TASKS - 1] = sum;
+}
+
+static void prvControl(void *pvParam) {
+    (void) pvParam;
+    tman_stats_t stats;
+    unsigned long jobs = 0, misses = 0, skipped = 0;
+
+    vTaskDelay(pdMS_TO_TICKS(bench_ticks * TICK_MS));
+
+    for (int k = 0; k < SET_TASKS; k++) {
+        if (TMAN_TaskStatsEx(tasks[k], &stats) == TMAN_SUCCESS) {
+            jobs += stats.ACTIVATIONS;
+            misses += stats.DEADLINE_MISSES;
+            skipped += stats.SKIPPED_RELEASES;
+        }
+    }
+
+    printf("%s,%d,%u,%lu,%lu,%lu,%.3f\n", bench_edf ? "edf" : "fp", bench_util, bench_seed,
+           jobs, misses, skipped, jobs ? 100.0 * misses / jobs : 0);
+    fflush(stdout);
+    exit(0);
+}
+
+int main(int argc, char *argv[]) {
+    static char names[SET_TASKS][8];
+    char value[12];
+    double u[SET_TASKS];
+
+    if (argc < 4 || argc > 5 || (strcmp(argv[1], "fp") != 0 && strcmp(argv[1], "edf") != 0)) {
+        fprintf(stderr, "usage: %s <fp|edf> <utilization %%> <seed> [ticks]\n", argv[0]);
+        return 1;
+    }
+    bench_edf = strcmp(argv[1], "edf") == 0;
+    bench_util = atoi(argv[2]);
+    bench_seed = atoi(argv[3]);
+    if (argc > 4)
+        bench_ticks = atoi(argv[4]);
+    if (bench_util <= 0 || bench_util > 100 || bench_ticks <= 0) {
+        fprintf(stderr, "utilization must be 1..100\n");
+        return 1;
+    }
+
+    TMAN_InitMode(TICK_MS, bench_edf ? TMAN_MODE_EDF : TMAN_MODE_ASSIGN_RM);
+
+    srand(bench_seed);
+    prvUUniFast(bench_util / 100.0, u);
+    for (int k = 0; k < SET_TASKS; k++) {
+        int period = PERIOD_MIN + rand() % (PERIOD_MAX - PERIOD_MIN + 1);
+        work_ns[k] = (uint32_t) (u[k] * period * TICK_MS * 1000000.0);
+
+        sprintf(names[k], "T%d", k);
+        tasks[k] = TMAN_TaskAdd(names[k]);
+        xTaskCreate(prvTask, names[k], configMINIMAL_STACK_SIZE, (void *) (intptr_t) k, PRIORITY_TASK, NULL);
+        sprintf(value, "%d", period);
+        TMAN_TaskRegisterAttributesEx(tasks[k], "PERIOD", value);
+        TMAN_TaskRegisterAttributesEx(tasks[k], "OVERRUN", "SKIP");
+    }
+
+    xTaskCreate(prvControl, "CTRL", configMINIMAL_STACK_SIZE, NULL, PRIORITY_CONTROL, NULL);
+
+    vTaskStartScheduler();
+
+    return 1;
+}
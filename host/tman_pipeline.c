@@ -0,0 +1,187 @@
+/*
+ * File:   tman_pipeline.c
+ * Author: André Alves
+ * Author: Eduardo Coelho
+ *
+ * Target: host (FreeRTOS POSIX port)
+ *   tman_pipeline <chain|mesh> [nodes] [ticks]
+ *
+ * Overview:
+ *          Precedence graph benchmark: <nodes> (default 50) empty
+ *          periodic tasks with the same period, linked by TMAN
+ *          precedence edges, one CSV row, times in microseconds:
+ *          - chain: each node after the previous one (depth = nodes)
+ *          - mesh: a source, layers of MESH_WIDTH nodes that each wait
+ *            for every node of the layer before (fan-out and fan-in of
+ *            MESH_WIDTH), and a sink
+ *          - dispatch: CPU time of the TMAN task per tick
+ *          - e2e: source job start to sink job completion
+ *          - hop: e2e over the depth of the graph
+ *          The bench_pipeline CMake target runs both shapes.
+ *          Host timings include the POSIX port's thread switches, use
+ *          them to compare TMAN revisions, not as PIC32 figures.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "tman.h"
+
+
+#define PRIORITY_NODE       ( tskIDLE_PRIORITY + 2 )
+#define PRIORITY_CONTROL    ( TMAN_PRIORITY + 1 )
+
+#define PIPELINE_PERIOD     "20"
+#define MESH_WIDTH          TMAN_MAX_PREDECESSORS
+// Source jobs whose start is kept until the sink completes them
+#define E2E_RING            16
+
+static int bench_ticks = 2000;
+static int bench_nodes = 50;
+static int bench_mesh = 0;
+static int bench_depth;
+static int bench_edges;
+
+static tman_handle_t nodes[TMAN_MAX_TASKS];
+static uint32_t source_start[E2E_RING];
+static uint64_t e2e_sum;
+static uint32_t e2e_max;
+static uint32_t e2e_count;
+
+static uint32_t prvNowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t) ((uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+static void prvSource(void *pvParam) {
+    tman_handle_t task = (tman_handle_t) pvParam;
+    uint32_t job = 0;
+
+    for (;;) {
+        TMAN_TaskWaitPeriodEx(task);
+        source_start[job++ % E2E_RING] = prvNowNs();
+    }
+}
+
+static void prvNode(void *pvParam) {
+    tman_handle_t task = (tman_handle_t) pvParam;
+
+    for (;;)
+        TMAN_TaskWaitPeriodEx(task);
+}
+
+/* Job k of the sink completes the graph run started by source job k */
+static void prvSink(void *pvParam) {
+    tman_handle_t task = (tman_handle_t) pvParam;
+    uint32_t job = 0;
+
+    TMAN_TaskWaitPeriodEx(task);
+    for (;;) {
+        uint32_t e2e = prvNowNs() - source_start[job++ % E2E_RING];
+        e2e_sum += e2e;
+        if (e2e > e2e_max)
+            e2e_max = e2e;
+        e2e_count++;
+        TMAN_TaskWaitPeriodEx(task);
+    }
+}
+
+static void prvControl(void *pvParam) {
+    static TaskStatus_t status[TMAN_MAX_TASKS + 16];
+    uint32_t total;
+    unsigned long dispatch = 0;
+    uint32_t misses = 0;
+    tman_stats_t stats;
+
+    vTaskDelay(bench_ticks);
+
+    int n = uxTaskGetSystemState(status, sizeof(status) / sizeof(status[0]), &total);
+    for (int k = 0; k < n; k++) {
+        if (status[k].xHandle == xTaskGetHandle("TMAN"))
+            dispatch = status[k].ulRunTimeCounter;
+    }
+    for (int k = 0; k < bench_nodes; k++) {
+        if (TMAN_TaskStatsEx(nodes[k], &stats) == TMAN_SUCCESS)
+            misses += stats.DEADLINE_MISSES;
+    }
+
+    double e2e_avg = e2e_count ? e2e_sum / 1000.0 / e2e_count : 0;
+    printf("%s,%d,%d,%d,%.2f,%.2f,%.2f,%.2f,%lu\n", bench_mesh ? "mesh" : "chain",
+           bench_nodes, bench_edges, bench_depth, (double) dispatch / bench_ticks,
+           e2e_avg, e2e_max / 1000.0, e2e_avg / bench_depth, (unsigned long) misses);
+    fflush(stdout);
+    exit(0);
+}
+
+static void prvEdge(int node, int predecessor) {
+    if (TMAN_TaskAddPrecedence(nodes[node], nodes[predecessor]) != TMAN_SUCCESS) {
+        fprintf(stderr, "edge N%d -> N%d refused\n", predecessor, node);
+        exit(1);
+    }
+    bench_edges++;
+}
+
+int main(int argc, char *argv[]) {
+    static char names[TMAN_MAX_TASKS][8];
+
+    if (argc < 2 || argc > 4 || (strcmp(argv[1], "chain") != 0 && strcmp(argv[1], "mesh") != 0)) {
+        fprintf(stderr, "usage: %s <chain|mesh> [nodes] [ticks]\n", argv[0]);
+        return 1;
+    }
+    bench_mesh = strcmp(argv[1], "mesh") == 0;
+    if (argc > 2)
+        bench_nodes = atoi(argv[2]);
+    if (argc > 3)
+        bench_ticks = atoi(argv[3]);
+    if (bench_nodes < (bench_mesh ? MESH_WIDTH + 2 : 2) || bench_nodes > TMAN_MAX_TASKS || bench_ticks <= 0) {
+        fprintf(stderr, "nodes must be %d..%d\n", bench_mesh ? MESH_WIDTH + 2 : 2, TMAN_MAX_TASKS);
+        return 1;
+    }
+
+    // One TMAN tick per kernel tick
+    TMAN_Init(1);
+
+    for (int k = 0; k < bench_nodes; k++) {
+        sprintf(names[k], "N%d", k);
+        nodes[k] = TMAN_TaskAdd(names[k]);
+        TaskFunction_t body = k == 0 ? prvSource : k == bench_nodes - 1 ? prvSink : prvNode;
+        xTaskCreate(body, names[k], configMINIMAL_STACK_SIZE, (void *) nodes[k], PRIORITY_NODE, NULL);
+        TMAN_TaskRegisterAttributesEx(nodes[k], "PERIOD", PIPELINE_PERIOD);
+    }
+
+    if (!bench_mesh) {
+        for (int k = 1; k < bench_nodes; k++)
+            prvEdge(k, k - 1);
+        bench_depth = bench_nodes - 1;
+    } else {
+        // Nodes 1..: layers of MESH_WIDTH, the last one may be narrower
+        int first = 1, prev = 0, prev_count = 1;
+        bench_depth = 1;
+        while (first < bench_nodes - 1) {
+            int count = bench_nodes - 1 - first < MESH_WIDTH ? bench_nodes - 1 - first : MESH_WIDTH;
+            for (int k = first; k < first + count; k++) {
+                for (int p = prev; p < prev + prev_count; p++)
+                    prvEdge(k, p);
+            }
+            prev = first;
+            prev_count = count;
+            first += count;
+            bench_depth++;
+        }
+        for (int p = prev; p < prev + prev_count; p++)
+            prvEdge(bench_nodes - 1, p);
+    }
+
+    xTaskCreate(prvControl, "CTRL", configMINIMAL_STACK_SIZE, NULL, PRIORITY_CONTROL, NULL);
+
+    vTaskStartScheduler();
+
+    return 1;
+}
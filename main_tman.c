@@ -58,24 +58,53 @@
 #define PRIORITY_E        ( tskIDLE_PRIORITY +  2 )
 #define PRIORITY_F        ( tskIDLE_PRIORITY +  2 )
 
+/* Set to 1 to overload task B: each job runs for 1.5 TMAN ticks, so its
+ * releases pile up and the BACKLOG attribute decides what happens to
+ * them (see the stats printed by the TMAN task). A DEMO_BUDGET other than
+ * "0" (microseconds) demotes each job to background once it used that
+ * much CPU, so the tasks below B keep running. */
+#define DEMO_OVERLOAD     0
+#define DEMO_BACKLOG      "COALESCE"
+#define DEMO_BUDGET       "0"
+
+static tman_handle_t overloaded = NULL;
+
 void taskBody( void * pvParameters ) {
+    tman_handle_t task = (tman_handle_t) pvParameters;
+    
     for (;;) {
         // Wait for the next cycle.
-        TMAN_TaskWaitPeriod((char *) pvParameters);
+        TMAN_TaskWaitPeriodEx(task);
         
         int tcks = xTaskGetTickCount();
         
-        uint8_t message[80];
-        sprintf(message, "%s, %d\n\r", ((char *) pvParameters), tcks);
-        PrintStr(message);        
+        // Formatted and printed later by the TMAN console task
+        TMAN_Log("%s, %d\n\r", TMAN_TaskGetName(task), tcks);
         
         int i, j,k;
         for (i = 0; i < 36; i++)
             for (j = 0; j < 36; j++)
                 k = i*j;
+        
+        // Sustained overload: busy until 1.5 ticks after the start
+        if (task == overloaded)
+            while (xTaskGetTickCount() - tcks < 3 * PERIOD_100MS)
+                ;
     }
 }
 
+// 200ms tick
+// Task, Body, Priority, Period, Phase, Deadline, WCET (us, 0 = unknown), Dependency
+#define DEMO_TASKS(X, s) \
+    X(s, A, taskBody, PRIORITY_A, 1, 0, 1, 0, NONE) \
+    X(s, B, taskBody, PRIORITY_B, 1, 0, 1, 0, F)    \
+    X(s, C, taskBody, PRIORITY_C, 3, 0, 3, 0, NONE) \
+    X(s, D, taskBody, PRIORITY_D, 3, 1, 3, 0, NONE) \
+    X(s, E, taskBody, PRIORITY_E, 4, 0, 4, 0, NONE) \
+    X(s, F, taskBody, PRIORITY_F, 4, 2, 4, 0, NONE)
+
+TMAN_TASK_SET(demo, DEMO_TASKS, PERIOD_200MS);
+
 ///*
 // * Create the demo tasks then start the scheduler.
 // */
@@ -101,230 +130,28 @@ int main_tman( void ) {
     printf("\n\r%-14s - %-5d\n\r%-15s - %-5d", "Eduardo Coelho", 88867, "André Alves", 88811);
     
     printf("\n\n*********************************************\n\r");
-    /* Create the tasks defined within this file. */
-    xTaskCreate(taskBody, (const signed char * const) "A",
-                configMINIMAL_STACK_SIZE, (void *) "A", PRIORITY_A, NULL);
-    xTaskCreate(taskBody, (const signed char * const) "B",
-                configMINIMAL_STACK_SIZE, (void *) "B", PRIORITY_B, NULL);
-    xTaskCreate(taskBody, (const signed char * const) "C",
-                configMINIMAL_STACK_SIZE, (void *) "C", PRIORITY_C, NULL);
-    xTaskCreate(taskBody, (const signed char * const) "D",
-                configMINIMAL_STACK_SIZE, (void *) "D", PRIORITY_D, NULL);
-    xTaskCreate(taskBody, (const signed char * const) "E",
-                configMINIMAL_STACK_SIZE, (void *) "E", PRIORITY_E, NULL);
-    xTaskCreate(taskBody, (const signed char * const) "F",
-                configMINIMAL_STACK_SIZE, (void *) "F", PRIORITY_F, NULL);
-        
-    TMAN_Init(PERIOD_200MS);
-    
-
-    // CONFIG TO SEND
-    // 200ms tick
-    // Task, Priority, Period, Phase, Dependencies
-    //  A,4,1,0
-    //  B,4,1,0,F
-    //  C,3,3,0
-    //  D,3,3,1
-    //  E,2,4,0
-    //  F,2,4,2
-    
-    
-    int err;
-
-    
-    if (TMAN_TaskAdd("A") == TMAN_FAIL_TASK_ALREADY_CREATED){
-        printf("Task Already Created\nExiting\n");
-        return -1;
-    }
-    
-    if (TMAN_TaskAdd("B") == TMAN_FAIL_TASK_ALREADY_CREATED) {
-        printf("Task Already Created\nExiting\n");
-        return -1;
-    }
+    // Priorities come from the registered periods, PRIORITY_A..F only
+    // apply until the dispatcher starts
+    TMAN_InitMode(PERIOD_200MS, TMAN_MODE_ASSIGN_RM);
     
-    if (TMAN_TaskAdd("C") == TMAN_FAIL_TASK_ALREADY_CREATED) {
-        printf("Task Already Created\nExiting\n");
-        return -1;
-    }
 
-    if (TMAN_TaskAdd("D") == TMAN_FAIL_TASK_ALREADY_CREATED) {
-        printf("Task Already Created\nExiting\n");
-        return -1;
-    }
+    // Tasks A..F (see DEMO_TASKS), checked at compile time
+    tman_handle_t handles[demo_COUNT];
     
-    if (TMAN_TaskAdd("E") == TMAN_FAIL_TASK_ALREADY_CREATED) {
-        printf("Task Already Created\nExiting\n");
-        return -1;
-    }
-
-    if (TMAN_TaskAdd("F") == TMAN_FAIL_TASK_ALREADY_CREATED) {
+    int err = TMAN_TaskSetLoad(demo, demo_COUNT, handles);
+    if (err == TMAN_FAIL_TASK_LIST_FULL) {
         printf("Task Already Created\nExiting\n");
         return -1;
-    }
-    
-    err = TMAN_TaskRegisterAttributes("A", "PERIOD", "1");
-    if (err == TMAN_FAIL_INVALID_ATTRIBUTE){
-        printf("Invalid Attribute\nExiting\n");
-        return -1;
-    } else if ( err == TMAN_FAIL_TASK_NOT_CREATED){
-        printf("Task Not Created\nExiting\n");
-        return -1;
-    }
-    
-    err = TMAN_TaskRegisterAttributes("A", "PHASE", "0");
-    if (err == TMAN_FAIL_INVALID_ATTRIBUTE) {
-        printf("Invalid Attribute\nExiting\n");
-        return -1;
-    } else if (err == TMAN_FAIL_TASK_NOT_CREATED) {
-        printf("Task Not Created\nExiting\n");
-        return -1;
-    }
-    
-    err = TMAN_TaskRegisterAttributes("A", "DEADLINE", "1");
-    if (err == TMAN_FAIL_INVALID_ATTRIBUTE) {
-        printf("Invalid Attribute\nExiting\n");
-        return -1;
-    } else if (err == TMAN_FAIL_TASK_NOT_CREATED) {
-        printf("Task Not Created\nExiting\n");
-        return -1;
-    }
-    
-    err = TMAN_TaskRegisterAttributes("B", "PERIOD", "1");
-    if (err == TMAN_FAIL_INVALID_ATTRIBUTE) {
-        printf("Invalid Attribute\nExiting\n");
-        return -1;
-    } else if (err == TMAN_FAIL_TASK_NOT_CREATED) {
-        printf("Task Not Created\nExiting\n");
-        return -1;
-    }
-    
-    err = TMAN_TaskRegisterAttributes("B", "PHASE", "0");
-    if (err == TMAN_FAIL_INVALID_ATTRIBUTE) {
-        printf("Invalid Attribute\nExiting\n");
-        return -1;
-    } else if (err == TMAN_FAIL_TASK_NOT_CREATED) {
-        printf("Task Not Created\nExiting\n");
-        return -1;
-    }
-    
-    err = TMAN_TaskRegisterAttributes("B", "DEADLINE", "1");
-    if (err == TMAN_FAIL_INVALID_ATTRIBUTE) {
-        printf("Invalid Attribute\nExiting\n");
-        return -1;
-    } else if (err == TMAN_FAIL_TASK_NOT_CREATED) {
-        printf("Task Not Created\nExiting\n");
-        return -1;
-    }
-    
-    err = TMAN_TaskRegisterAttributes("C", "PERIOD", "3");
-    if (err == TMAN_FAIL_INVALID_ATTRIBUTE) {
-        printf("Invalid Attribute\nExiting\n");
-        return -1;
-    } else if (err == TMAN_FAIL_TASK_NOT_CREATED) {
-        printf("Task Not Created\nExiting\n");
-        return -1;
-    }
-
-    err = TMAN_TaskRegisterAttributes("C", "PHASE", "0");
-    if (err == TMAN_FAIL_INVALID_ATTRIBUTE) {
-        printf("Invalid Attribute\nExiting\n");
-        return -1;
-    } else if (err == TMAN_FAIL_TASK_NOT_CREATED) {
-        printf("Task Not Created\nExiting\n");
-        return -1;
-    }
-
-    err = TMAN_TaskRegisterAttributes("C", "DEADLINE", "3");
-    if (err == TMAN_FAIL_INVALID_ATTRIBUTE) {
-        printf("Invalid Attribute\nExiting\n");
-        return -1;
-    } else if (err == TMAN_FAIL_TASK_NOT_CREATED) {
-        printf("Task Not Created\nExiting\n");
-        return -1;
-    }
-    
-    err = TMAN_TaskRegisterAttributes("D", "PERIOD", "3");
-    if (err == TMAN_FAIL_INVALID_ATTRIBUTE) {
-        printf("Invalid Attribute\nExiting\n");
-        return -1;
-    } else if (err == TMAN_FAIL_TASK_NOT_CREATED) {
-        printf("Task Not Created\nExiting\n");
-        return -1;
-    }
-
-    err = TMAN_TaskRegisterAttributes("D", "PHASE", "1");
-    if (err == TMAN_FAIL_INVALID_ATTRIBUTE) {
+    } else if (err != TMAN_SUCCESS) {
         printf("Invalid Attribute\nExiting\n");
         return -1;
-    } else if (err == TMAN_FAIL_TASK_NOT_CREATED) {
-        printf("Task Not Created\nExiting\n");
-        return -1;
-    }
-
-    err = TMAN_TaskRegisterAttributes("D", "DEADLINE", "3");
-    if (err == TMAN_FAIL_INVALID_ATTRIBUTE) {
-        printf("Invalid Attribute\nExiting\n");
-        return -1;
-    } else if (err == TMAN_FAIL_TASK_NOT_CREATED) {
-        printf("Task Not Created\nExiting\n");
-        return -1;
-    }
-
-    err = TMAN_TaskRegisterAttributes("E", "PERIOD", "4");
-    if (err == TMAN_FAIL_INVALID_ATTRIBUTE) {
-        printf("Invalid Attribute\nExiting\n");
-        return -1;
-    } else if (err == TMAN_FAIL_TASK_NOT_CREATED) {
-        printf("Task Not Created\nExiting\n");
-        return -1;
-    }
-
-    err = TMAN_TaskRegisterAttributes("E", "PHASE", "0");
-    if (err == TMAN_FAIL_INVALID_ATTRIBUTE) {
-        printf("Invalid Attribute\nExiting\n");
-        return -1;
-    } else if (err == TMAN_FAIL_TASK_NOT_CREATED) {
-        printf("Task Not Created\nExiting\n");
-        return -1;
-    }
-
-    err = TMAN_TaskRegisterAttributes("E", "DEADLINE", "4");
-    if (err == TMAN_FAIL_INVALID_ATTRIBUTE) {
-        printf("Invalid Attribute\nExiting\n");
-        return -1;
-    } else if (err == TMAN_FAIL_TASK_NOT_CREATED) {
-        printf("Task Not Created\nExiting\n");
-        return -1;
-    }
-
-    err = TMAN_TaskRegisterAttributes("F", "PERIOD", "4");
-    if (err == TMAN_FAIL_INVALID_ATTRIBUTE) {
-        printf("Invalid Attribute\nExiting\n");
-        return -1;
-    } else if (err == TMAN_FAIL_TASK_NOT_CREATED) {
-        printf("Task Not Created\nExiting\n");
-        return -1;
-    }
-
-    err = TMAN_TaskRegisterAttributes("F", "PHASE", "2");
-    if (err == TMAN_FAIL_INVALID_ATTRIBUTE) {
-        printf("Invalid Attribute\nExiting\n");
-        return -1;
-    } else if (err == TMAN_FAIL_TASK_NOT_CREATED) {
-        printf("Task Not Created\nExiting\n");
-        return -1;
-    }
-
-    err = TMAN_TaskRegisterAttributes("F", "DEADLINE", "4");
-    if (err == TMAN_FAIL_INVALID_ATTRIBUTE) {
-        printf("Invalid Attribute\nExiting\n");
-        return -1;
-    } else if (err == TMAN_FAIL_TASK_NOT_CREATED) {
-        printf("Task Not Created\nExiting\n");
-        return -1;
     }
     
-    TMAN_TaskRegisterAttributes("B", "PRECEDENCE", "F");
+#if DEMO_OVERLOAD
+    TMAN_TaskRegisterAttributesEx(handles[demo_ID_B], "BACKLOG", DEMO_BACKLOG);
+    TMAN_TaskRegisterAttributesEx(handles[demo_ID_B], "BUDGET", DEMO_BUDGET);
+    overloaded = handles[demo_ID_B];
+#endif
     
     /* Finally start the scheduler. */
     vTaskStartScheduler();
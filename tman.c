@@ -16,7 +16,11 @@
  */
 
 
+#ifdef __XC32
 #include <xc.h>
+#else
+#include <time.h>
+#endif
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
@@ -29,260 +33,3668 @@
 /* App includes */
 #include "../UART/uart.h"
 #include "tman.h"
+#include "tman_analysis.h"
+#if TMAN_TRACE
+#include "tman_trace.h"
+#endif
 
 
-static TickType_t tman_ticks = 0;
+#ifdef __XC32
+/* PIC32 core timer, counts at half the CPU clock */
+#define TMAN_TIMESTAMP()    ((uint32_t) _CP0_GET_COUNT())
+#define TMAN_TIMESTAMP_HZ   (configCPU_CLOCK_HZ / 2)
+#else
+/* Host stand-in: monotonic clock in nanoseconds, wraps like the core timer */
+static uint32_t prvTMAN_HostTimestamp(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t) ((uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+#define TMAN_TIMESTAMP()    prvTMAN_HostTimestamp()
+#define TMAN_TIMESTAMP_HZ   1000000000ULL
+#endif
+
+/* Stats sequence counters. Each block of task fields has one writer,
+ * which makes the counter odd around its updates; readers copy the block
+ * and retry if the counter was odd or moved. The fences are a single
+ * "sync" on the PIC32. */
+#define TMAN_FENCE()        __sync_synchronize()
+
+static void prvTMAN_SeqBegin(volatile uint32_t *seq) {
+    (*seq)++;
+    TMAN_FENCE();
+}
+
+static void prvTMAN_SeqEnd(volatile uint32_t *seq) {
+    TMAN_FENCE();
+    (*seq)++;
+}
+
+#if TMAN_TRACE
+#define TMAN_TRACE_EVENT(event, task, arg) \
+    TMAN_TraceWrite(TMAN_TIMESTAMP(), (event), (task) - tman_task_list, (arg))
+#else
+#define TMAN_TRACE_EVENT(event, task, arg)  do { } while (0)
+#endif
+
+static tman_time_t tman_ticks = 0;
+
+static int tman_period;
+
+/* Task registry: fixed slots, unused ones chained in an intrusive free list */
+static task_tman tman_task_list[TMAN_MAX_TASKS];
+static task_tman *tman_free_list = NULL;
+static int tman_list_ready = 0;
+
+/* Release queue: binary min-heap of tasks keyed by NEXT_RELEASE */
+static task_tman *tman_heap[TMAN_MAX_TASKS];
+static int tman_heap_size = 0;
+static TaskHandle_t tman_handle = NULL;
+static int tman_running = 0;
+
+/* EDF deadline queue: pending jobs (released, not completed) ordered by
+ * absolute deadline. */
+static task_tman *tman_edf_heap[TMAN_MAX_TASKS];
+static int tman_edf_size = 0;
+// Task currently holding TMAN_EDF_PRIORITY_HIGH
+static task_tman *tman_edf_current = NULL;
+
+/* Deadline watch queue: the oldest pending job of each task, keyed by its
+ * absolute deadline, so the dispatcher wakes at the deadline instant */
+static task_tman *tman_watch_heap[TMAN_MAX_TASKS];
+static int tman_watch_size = 0;
+
+/* Budget watch queue: tasks with a CPU budget and a job outstanding, keyed
+ * by the kernel tick the job could use it up at the earliest */
+static task_tman *tman_budget_heap[TMAN_MAX_TASKS];
+static int tman_budget_size = 0;
+
+/* Time-triggered mode: release instants over one hyperperiod, each with the
+ * bitmask of the tasks it releases. Bit k refers to tman_tt_order[k], which
+ * lists predecessors before their dependents. */
+#define TMAN_TT_MASK_WORDS  ((TMAN_MAX_TASKS + 31) / 32)
+
+typedef struct tman_tt_entry {
+    uint32_t OFFSET;
+    uint32_t MASK[TMAN_TT_MASK_WORDS];
+} tman_tt_entry;
+
+static int tman_mode = TMAN_MODE_EVENT;
+static tman_tt_entry tman_tt_table[TMAN_TT_TABLE_SIZE];
+static task_tman *tman_tt_order[TMAN_MAX_TASKS];
+static int tman_tt_count = 0;
+static uint32_t tman_tt_hyperperiod = 0;
+static int tman_tt_pos = 0;
+static tman_time_t tman_tt_base = 0;
+static int tman_tt_dirty = 0;
+
+/* Executors of the run-to-completion jobs, one per band, created with
+ * the first job of their band. READY has one bit per task slot. */
+typedef struct tman_executor {
+    TaskHandle_t HANDLE;
+    volatile uint32_t READY[TMAN_TT_MASK_WORDS];
+} tman_executor;
+
+static tman_executor tman_executors[TMAN_EXECUTOR_BANDS];
+
+/* Shared resources, see TMAN_ResourceDeclare() */
+static tman_resource tman_resources[TMAN_MAX_RESOURCES];
+
+/* Sporadic tasks triggered since the dispatcher last looked, one bit per
+ * registry slot, set from tasks and ISRs */
+static volatile uint32_t tman_trigger_mask[TMAN_TT_MASK_WORDS];
+
+/* Operating modes: alternative task sets resolved and checked by
+ * TMAN_ModeDefine(), applied whole by the dispatcher at a safe point */
+typedef struct tman_mode_entry {
+    task_tman *TASK;
+    task_tman *PREDECESSOR;     // NULL if none
+    int PERIOD;
+    int PHASE;
+    int DEADLINE;
+    int WCET;
+} tman_mode_entry;
+
+typedef struct tman_opmode {
+    int COUNT;                  // 0 while undefined
+    tman_mode_entry TASKS[TMAN_MAX_TASKS];
+} tman_opmode;
+
+static tman_opmode tman_opmodes[TMAN_MAX_MODES];
+static tman_mode_status_t tman_mode_status = { -1, -1 };
+static int tman_switch_when;
+static tman_time_t tman_switch_requested;
+static tman_time_t tman_switch_at;          // next instant the safe point is tried
+static tman_time_t tman_switch_expires;
+static uint64_t tman_switch_hyperperiod;    // of the mode being left
+static tman_time_t tman_mode_origin = 0;    // release origin of the mode in force
+
+#define TMAN_TIME_NEVER     UINT64_MAX
+
+#define TMAN_COUNTS_PER_US  ((uint32_t) (TMAN_TIMESTAMP_HZ / 1000000))
+#define TMAN_US_PER_TICK    (1000000UL / configTICK_RATE_HZ)
+
+/* Counting semaphore limit for joins released but not yet taken */
+#define TMAN_JOIN_MAX       255
+
+static unsigned tman_visit_mark = 0;
+
+/* 64-bit extension of the kernel tick count: kernel ticks elapsed since TMAN
+ * started, and the 32-bit tick count at which it was last refreshed */
+static uint64_t tman_kernel_epoch = 0;
+static TickType_t tman_kernel_base = 0;
+
+static uint64_t prvTMAN_KernelTime(void) {
+    uint64_t kernel;
+
+    taskENTER_CRITICAL();
+    TickType_t now = xTaskGetTickCount();
+    kernel = tman_kernel_epoch + (TickType_t) (now - tman_kernel_base);
+    tman_kernel_epoch = kernel;
+    tman_kernel_base = now;
+    taskEXIT_CRITICAL();
+
+    return kernel;
+}
+
+static tman_time_t prvTMAN_Now(void) {
+    return prvTMAN_KernelTime() / tman_period;
+}
+
+/* Name lookup, only used by the string compatibility API */
+static task_tman *prvTMAN_Find(const char taskName[]) {
+    for (int i = 0; i < TMAN_MAX_TASKS; i++) {
+        if (tman_task_list[i].IN_USE && strcmp(tman_task_list[i].NAME, taskName) == 0)
+            return &tman_task_list[i];
+    }
+    return NULL;
+}
+
+/* Cache the kernel handle and tag the kernel task with its TMAN task, so
+ * the context switch hooks can account execution time */
+static void prvTMAN_Bind(task_tman *task, TaskHandle_t handle) {
+    // A job runs on its executor, it has no kernel task of its own
+    if (task->JOB_FN != NULL)
+        return;
+    task->TASK_HANDLE = handle;
+#if configUSE_APPLICATION_TASK_TAG == 1
+    if (handle != NULL)
+        vTaskSetApplicationTaskTag(handle, (TaskHookFunction_t) task);
+#endif
+    // Static priorities from xTaskCreate() do not apply under EDF
+    if (handle != NULL && (tman_mode & TMAN_MODE_EDF))
+        vTaskPrioritySet(handle, task == tman_edf_current ? TMAN_EDF_PRIORITY_HIGH : TMAN_EDF_PRIORITY_LOW);
+    else if (handle != NULL && task->ASSIGNED_PRIORITY != 0)
+        vTaskPrioritySet(handle, task->ASSIGNED_PRIORITY);
+}
+
+/* Priority a task runs at: its executor's for a job, 0 while the kernel
+ * task is unknown */
+static UBaseType_t prvTMAN_Priority(task_tman *task) {
+    if (task->JOB_FN != NULL)
+        return TMAN_EXECUTOR_PRIORITY + task->BAND;
+    return task->TASK_HANDLE != NULL ? uxTaskPriorityGet(task->TASK_HANDLE) : 0;
+}
+
+/* Priority of a task outside critical sections */
+static UBaseType_t prvTMAN_BasePriority(task_tman *task) {
+    if (task->ASSIGNED_PRIORITY != 0 && task->JOB_FN == NULL)
+        return task->ASSIGNED_PRIORITY;
+    return prvTMAN_Priority(task);
+}
+
+/* Ceiling of every resource from the priorities of its users. Called
+ * where priorities settle and no resource is held: declarations, the
+ * dispatcher start, mode switches. */
+static void prvTMAN_ResourceCeilings(void) {
+    for (int r = 0; r < TMAN_MAX_RESOURCES; r++) {
+        tman_resource *resource = &tman_resources[r];
+        UBaseType_t ceiling = 0;
+
+        for (int k = 0; k < resource->NUM_USERS; k++) {
+            UBaseType_t priority = prvTMAN_BasePriority(resource->USERS[k]);
+            if (priority > ceiling)
+                ceiling = priority;
+        }
+        resource->CEILING = ceiling;
+    }
+}
+
+/* Chain every slot in the free list, done once on the first TMAN_TaskAdd() */
+static void prvTMAN_ListInit(void) {
+    for (int i = TMAN_MAX_TASKS - 1; i >= 0; i--) {
+        tman_task_list[i].NEXT_FREE = tman_free_list;
+        tman_free_list = &tman_task_list[i];
+    }
+    tman_list_ready = 1;
+}
+
+static void prvTMAN_HeapSwap(int a, int b) {
+    task_tman *tmp = tman_heap[a];
+    tman_heap[a] = tman_heap[b];
+    tman_heap[b] = tmp;
+    tman_heap[a]->HEAP_INDEX = a;
+    tman_heap[b]->HEAP_INDEX = b;
+}
+
+static void prvTMAN_HeapUp(int pos) {
+    while (pos > 0) {
+        int parent = (pos - 1) / 2;
+        if (tman_heap[parent]->NEXT_RELEASE <= tman_heap[pos]->NEXT_RELEASE)
+            break;
+        prvTMAN_HeapSwap(pos, parent);
+        pos = parent;
+    }
+}
+
+static void prvTMAN_HeapDown(int pos) {
+    for (;;) {
+        int smallest = pos;
+        int left = 2 * pos + 1;
+        int right = left + 1;
+        if (left < tman_heap_size && tman_heap[left]->NEXT_RELEASE < tman_heap[smallest]->NEXT_RELEASE)
+            smallest = left;
+        if (right < tman_heap_size && tman_heap[right]->NEXT_RELEASE < tman_heap[smallest]->NEXT_RELEASE)
+            smallest = right;
+        if (smallest == pos)
+            break;
+        prvTMAN_HeapSwap(pos, smallest);
+        pos = smallest;
+    }
+}
+
+static void prvTMAN_HeapRemove(task_tman *task) {
+    int pos = task->HEAP_INDEX;
+
+    if (pos < 0)
+        return;
+
+    tman_heap_size--;
+    if (pos != tman_heap_size) {
+        prvTMAN_HeapSwap(pos, tman_heap_size);
+        prvTMAN_HeapUp(pos);
+        prvTMAN_HeapDown(pos);
+    }
+    task->HEAP_INDEX = -1;
+}
+
+static void prvTMAN_EdfSwap(int a, int b) {
+    task_tman *tmp = tman_edf_heap[a];
+    tman_edf_heap[a] = tman_edf_heap[b];
+    tman_edf_heap[b] = tmp;
+    tman_edf_heap[a]->EDF_INDEX = a;
+    tman_edf_heap[b]->EDF_INDEX = b;
+}
+
+static void prvTMAN_EdfUp(int pos) {
+    while (pos > 0) {
+        int parent = (pos - 1) / 2;
+        if (tman_edf_heap[parent]->ABS_DEADLINE <= tman_edf_heap[pos]->ABS_DEADLINE)
+            break;
+        prvTMAN_EdfSwap(pos, parent);
+        pos = parent;
+    }
+}
+
+static void prvTMAN_EdfDown(int pos) {
+    for (;;) {
+        int smallest = pos;
+        int left = 2 * pos + 1;
+        int right = left + 1;
+        if (left < tman_edf_size && tman_edf_heap[left]->ABS_DEADLINE < tman_edf_heap[smallest]->ABS_DEADLINE)
+            smallest = left;
+        if (right < tman_edf_size && tman_edf_heap[right]->ABS_DEADLINE < tman_edf_heap[smallest]->ABS_DEADLINE)
+            smallest = right;
+        if (smallest == pos)
+            break;
+        prvTMAN_EdfSwap(pos, smallest);
+        pos = smallest;
+    }
+}
+
+static void prvTMAN_EdfInsert(task_tman *task, tman_time_t deadline) {
+    task->ABS_DEADLINE = deadline;
+    task->EDF_INDEX = tman_edf_size;
+    tman_edf_heap[tman_edf_size++] = task;
+    prvTMAN_EdfUp(task->EDF_INDEX);
+}
+
+static void prvTMAN_EdfRemove(task_tman *task) {
+    int pos = task->EDF_INDEX;
+
+    if (pos < 0)
+        return;
+
+    tman_edf_size--;
+    if (pos != tman_edf_size) {
+        prvTMAN_EdfSwap(pos, tman_edf_size);
+        prvTMAN_EdfUp(pos);
+        prvTMAN_EdfDown(pos);
+    }
+    task->EDF_INDEX = -1;
+}
+
+static void prvTMAN_WatchSwap(int a, int b) {
+    task_tman *tmp = tman_watch_heap[a];
+    tman_watch_heap[a] = tman_watch_heap[b];
+    tman_watch_heap[b] = tmp;
+    tman_watch_heap[a]->WATCH_INDEX = a;
+    tman_watch_heap[b]->WATCH_INDEX = b;
+}
+
+static void prvTMAN_WatchUp(int pos) {
+    while (pos > 0) {
+        int parent = (pos - 1) / 2;
+        if (tman_watch_heap[parent]->DEADLINE_AT <= tman_watch_heap[pos]->DEADLINE_AT)
+            break;
+        prvTMAN_WatchSwap(pos, parent);
+        pos = parent;
+    }
+}
+
+static void prvTMAN_WatchDown(int pos) {
+    for (;;) {
+        int smallest = pos;
+        int left = 2 * pos + 1;
+        int right = left + 1;
+        if (left < tman_watch_size && tman_watch_heap[left]->DEADLINE_AT < tman_watch_heap[smallest]->DEADLINE_AT)
+            smallest = left;
+        if (right < tman_watch_size && tman_watch_heap[right]->DEADLINE_AT < tman_watch_heap[smallest]->DEADLINE_AT)
+            smallest = right;
+        if (smallest == pos)
+            break;
+        prvTMAN_WatchSwap(pos, smallest);
+        pos = smallest;
+    }
+}
+
+static void prvTMAN_WatchInsert(task_tman *task, tman_time_t deadline) {
+    task->DEADLINE_AT = deadline;
+    task->WATCH_INDEX = tman_watch_size;
+    tman_watch_heap[tman_watch_size++] = task;
+    prvTMAN_WatchUp(task->WATCH_INDEX);
+}
+
+static void prvTMAN_WatchRemove(task_tman *task) {
+    int pos = task->WATCH_INDEX;
+
+    if (pos < 0)
+        return;
+
+    tman_watch_size--;
+    if (pos != tman_watch_size) {
+        prvTMAN_WatchSwap(pos, tman_watch_size);
+        prvTMAN_WatchUp(pos);
+        prvTMAN_WatchDown(pos);
+    }
+    task->WATCH_INDEX = -1;
+}
+
+static void prvTMAN_BudgetSwap(int a, int b) {
+    task_tman *tmp = tman_budget_heap[a];
+    tman_budget_heap[a] = tman_budget_heap[b];
+    tman_budget_heap[b] = tmp;
+    tman_budget_heap[a]->BUDGET_INDEX = a;
+    tman_budget_heap[b]->BUDGET_INDEX = b;
+}
+
+static void prvTMAN_BudgetUp(int pos) {
+    while (pos > 0) {
+        int parent = (pos - 1) / 2;
+        if (tman_budget_heap[parent]->BUDGET_AT <= tman_budget_heap[pos]->BUDGET_AT)
+            break;
+        prvTMAN_BudgetSwap(pos, parent);
+        pos = parent;
+    }
+}
+
+static void prvTMAN_BudgetDown(int pos) {
+    for (;;) {
+        int smallest = pos;
+        int left = 2 * pos + 1;
+        int right = left + 1;
+        if (left < tman_budget_size && tman_budget_heap[left]->BUDGET_AT < tman_budget_heap[smallest]->BUDGET_AT)
+            smallest = left;
+        if (right < tman_budget_size && tman_budget_heap[right]->BUDGET_AT < tman_budget_heap[smallest]->BUDGET_AT)
+            smallest = right;
+        if (smallest == pos)
+            break;
+        prvTMAN_BudgetSwap(pos, smallest);
+        pos = smallest;
+    }
+}
+
+static void prvTMAN_BudgetInsert(task_tman *task, uint64_t kernel) {
+    task->BUDGET_AT = kernel;
+    task->BUDGET_INDEX = tman_budget_size;
+    tman_budget_heap[tman_budget_size++] = task;
+    prvTMAN_BudgetUp(task->BUDGET_INDEX);
+}
+
+static void prvTMAN_BudgetRemove(task_tman *task) {
+    int pos = task->BUDGET_INDEX;
+
+    if (pos < 0)
+        return;
+
+    tman_budget_size--;
+    if (pos != tman_budget_size) {
+        prvTMAN_BudgetSwap(pos, tman_budget_size);
+        prvTMAN_BudgetUp(pos);
+        prvTMAN_BudgetDown(pos);
+    }
+    task->BUDGET_INDEX = -1;
+}
+
+/* Kernel ticks covering us microseconds, at least one */
+static uint64_t prvTMAN_UsToTicks(uint64_t us) {
+    return us > TMAN_US_PER_TICK ? (us + TMAN_US_PER_TICK - 1) / TMAN_US_PER_TICK : 1;
+}
+
+/* Hand TMAN_EDF_PRIORITY_HIGH to the earliest deadline pending job. Only
+ * the outgoing and the incoming task change priority, and none when the
+ * earliest job is the same. Called inside a critical section. */
+static void prvTMAN_EdfDispatch(void) {
+    task_tman *earliest = tman_edf_size > 0 ? tman_edf_heap[0] : NULL;
+
+    if (earliest == tman_edf_current)
+        return;
+
+    if (tman_edf_current != NULL && tman_edf_current->TASK_HANDLE != NULL)
+        vTaskPrioritySet(tman_edf_current->TASK_HANDLE, TMAN_EDF_PRIORITY_LOW);
+    if (earliest != NULL && earliest->TASK_HANDLE != NULL)
+        vTaskPrioritySet(earliest->TASK_HANDLE, TMAN_EDF_PRIORITY_HIGH);
+    tman_edf_current = earliest;
+}
+
+/* Compute the first release at or after now and (re)queue the task.
+ * Must be called with the heap protected (before the dispatcher starts
+ * or inside a critical section). */
+static void prvTMAN_Schedule(task_tman *task, tman_time_t now) {
+    tman_time_t next = task->ORIGIN + task->PHASE;
+
+    // The table is rebuilt at the next hyperperiod boundary instead
+    if (tman_mode & TMAN_MODE_TIME_TRIGGERED) {
+        tman_tt_dirty = 1;
+        return;
+    }
+
+    // Sporadic tasks are queued by their triggers only
+    if (task->PERIOD <= 0 || task->PAUSED || task->SPORADIC)
+        return;
+
+    if (now > next)
+        next += ((now - next + task->PERIOD - 1) / task->PERIOD) * task->PERIOD;
+    task->NEXT_RELEASE = next;
+
+    if (task->HEAP_INDEX < 0) {
+        task->HEAP_INDEX = tman_heap_size;
+        tman_heap[tman_heap_size++] = task;
+    }
+    prvTMAN_HeapUp(task->HEAP_INDEX);
+    prvTMAN_HeapDown(task->HEAP_INDEX);
+}
+
+static void prvTMAN_ScheduleAll(tman_time_t now) {
+    for (int i = 0; i < TMAN_MAX_TASKS; i++) {
+        if (tman_task_list[i].IN_USE)
+            prvTMAN_Schedule(&tman_task_list[i], now);
+    }
+}
+
+static uint64_t prvTMAN_Gcd(uint64_t a, uint64_t b) {
+    while (b != 0) {
+        uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/* Outcome of a release against the backlog of its task */
+#define TMAN_ADMIT_RUN      0   // nothing outstanding, runs right away
+#define TMAN_ADMIT_QUEUE    1   // waits behind an unfinished job
+#define TMAN_ADMIT_COALESCE 2   // taken over by the job waiting to start
+#define TMAN_ADMIT_DROP     3
+
+/* Apply the backlog policy of the task to one release.
+ * Called inside a critical section. */
+static int prvTMAN_Admit(task_tman *task) {
+    int waiting = task->OUTSTANDING - (task->JOB_ACTIVE ? 1 : 0);
+
+    if (task->TASK_HANDLE == NULL && task->JOB_FN == NULL)
+        return TMAN_ADMIT_DROP;
+
+    switch (task->BACKLOG_POLICY) {
+        case TMAN_BACKLOG_COALESCE:
+            if (waiting > 0)
+                return TMAN_ADMIT_COALESCE;
+            break;
+        case TMAN_BACKLOG_DROP:
+            if (task->OUTSTANDING > 0)
+                return TMAN_ADMIT_DROP;
+            break;
+        default:
+            if (task->OUTSTANDING >= task->BACKLOG_DEPTH)
+                return TMAN_ADMIT_DROP;
+            break;
+    }
+
+    return task->OUTSTANDING++ > 0 ? TMAN_ADMIT_QUEUE : TMAN_ADMIT_RUN;
+}
+
+/* Give a throttled job its priority, or the CPU, back: from the
+ * dispatcher when a release brings a new budget (refill, the job goes on
+ * with it), or from the task when the job completes */
+static void prvTMAN_Unthrottle(task_tman *task, int refill) {
+
+    taskENTER_CRITICAL();
+    int throttled = task->THROTTLED;
+    task->THROTTLED = 0;
+    if (throttled && refill)
+        task->JOB_EXEC = 0;
+    taskEXIT_CRITICAL();
+
+    if (!throttled || task->TASK_HANDLE == NULL)
+        return;
+
+    if (throttled - 1 == TMAN_BUDGET_SUSPEND)
+        vTaskResume(task->TASK_HANDLE);
+    else if (tman_mode & TMAN_MODE_EDF)
+        vTaskPrioritySet(task->TASK_HANDLE, TMAN_EDF_PRIORITY_LOW);
+    else
+        vTaskPrioritySet(task->TASK_HANDLE, task->SAVED_PRIORITY);
+}
+
+/* Mark a job ready to start and wake its executor */
+static void prvTMAN_JobReady(task_tman *task) {
+    tman_executor *executor = &tman_executors[task->BAND];
+    int slot = task - tman_task_list;
+
+    taskENTER_CRITICAL();
+    executor->READY[slot / 32] |= 1u << (slot % 32);
+    taskEXIT_CRITICAL();
+    xTaskNotifyGive(executor->HANDLE);
+}
+
+/* Notify one released job */
+static void prvTMAN_Release(task_tman *task, tman_time_t release) {
+
+    // A job over its budget goes on with the budget of this release
+    if (task->THROTTLED)
+        prvTMAN_Unthrottle(task, 1);
+
+    // TMAN_OVERRUN_SKIP: this release is dropped, as if it never came
+    if (task->SKIP_NEXT) {
+        task->SKIP_NEXT = 0;
+        prvTMAN_SeqBegin(&task->RELEASE_SEQ);
+        task->SKIPPED_RELEASES++;
+        prvTMAN_SeqEnd(&task->RELEASE_SEQ);
+        return;
+    }
+
+    // Resolved once if the task was created after TMAN_TaskAdd()
+    // and has not waited yet. Jobs have no task of their own.
+    if (task->TASK_HANDLE == NULL && task->JOB_FN == NULL)
+        prvTMAN_Bind(task, xTaskGetHandle(task->NAME));
+
+    taskENTER_CRITICAL();
+    int admit = prvTMAN_Admit(task);
+    // The job that answers this release is the newest outstanding one
+    int slot = 0;
+    if (admit != TMAN_ADMIT_DROP) {
+        slot = (task->JOB_HEAD + task->OUTSTANDING - 1) % TMAN_BACKLOG_MAX;
+        task->JOB_RELEASE[slot] = release;
+    }
+    taskEXIT_CRITICAL();
+
+    if (admit == TMAN_ADMIT_DROP) {
+        prvTMAN_SeqBegin(&task->RELEASE_SEQ);
+        task->DROPPED_RELEASES++;
+        prvTMAN_SeqEnd(&task->RELEASE_SEQ);
+        return;
+    }
+
+    // A sporadic job released right away answers from its trigger
+    uint32_t stamp = task->SPORADIC && task->PENDING_STAMP != 0 ? task->PENDING_STAMP : TMAN_TIMESTAMP();
+
+    prvTMAN_SeqBegin(&task->RELEASE_SEQ);
+
+    // Release jitter: deviation of the measured inter-release interval
+    // from the nominal one (skipped when it would overflow the counter)
+    if (task->RELEASE_COUNT > 0 && !task->SPORADIC) {
+        uint64_t nominal = (release - task->LAST_ACTIVATION) * tman_period * TMAN_TIMESTAMP_HZ / configTICK_RATE_HZ;
+        if (nominal < UINT32_MAX / 2) {
+            uint32_t interval = stamp - task->RELEASE_STAMP;
+            uint32_t deviation = interval > nominal ? interval - nominal : nominal - interval;
+            if (deviation > task->JITTER_MAX)
+                task->JITTER_MAX = deviation;
+        }
+    }
+    task->RELEASE_COUNT++;
+    task->RELEASE_STAMP = stamp;
+    task->JOB_STAMP[slot] = stamp;
+    task->LAST_ACTIVATION = release;
+    if (admit == TMAN_ADMIT_QUEUE)
+        task->QUEUED_RELEASES++;
+    else if (admit == TMAN_ADMIT_COALESCE)
+        task->COALESCED_RELEASES++;
+
+    prvTMAN_SeqEnd(&task->RELEASE_SEQ);
+    TMAN_TRACE_EVENT(TMAN_TRACE_RELEASE, task, 0);
+
+    // Watch the deadline of this job, unless an older one is still pending:
+    // its completion arms the watch for the next outstanding job
+    if (task->DEADLINE > 0) {
+        taskENTER_CRITICAL();
+        if (admit == TMAN_ADMIT_COALESCE && !task->JOB_ACTIVE) {
+            // The job waiting to start now answers this release
+            prvTMAN_WatchRemove(task);
+            task->LATE = 0;
+        }
+        if (task->WATCH_INDEX < 0 && !task->LATE)
+            prvTMAN_WatchInsert(task, release + task->DEADLINE);
+        taskEXIT_CRITICAL();
+    }
+
+    // The job can't use up its budget before release + BUDGET
+    if (task->BUDGET > 0 && task->BUDGET_INDEX < 0) {
+        taskENTER_CRITICAL();
+        prvTMAN_BudgetInsert(task, release * tman_period + prvTMAN_UsToTicks(task->BUDGET));
+        taskEXIT_CRITICAL();
+    }
+
+    // Already notified
+    if (admit == TMAN_ADMIT_COALESCE)
+        return;
+
+    // Jobs run in the order of their band's bitmap, EDF does not apply
+    if (task->JOB_FN != NULL) {
+        prvTMAN_JobReady(task);
+        return;
+    }
+
+    // A job still pending (overrun) keeps its earlier deadline
+    if ((tman_mode & TMAN_MODE_EDF) && task->EDF_INDEX < 0) {
+        taskENTER_CRITICAL();
+        prvTMAN_EdfInsert(task, release + task->DEADLINE);
+        prvTMAN_EdfDispatch();
+        taskEXIT_CRITICAL();
+    }
+
+#if TMAN_ACTIVATION_SUSPEND
+    vTaskResume(task->TASK_HANDLE);
+#else
+    // Counted: a release sent before the task blocks is kept
+    xTaskNotifyGive(task->TASK_HANDLE);
+#endif
+}
+
+/* Count the jobs still pending at their deadline instant and apply the
+ * overrun policy of their task, returns the next deadline to watch */
+static tman_time_t prvTMAN_CheckDeadlines(uint64_t kernel) {
+    tman_time_t next = TMAN_TIME_NEVER;
+
+    taskENTER_CRITICAL();
+    while (tman_watch_size > 0 && tman_watch_heap[0]->DEADLINE_AT * tman_period <= kernel) {
+        task_tman *task = tman_watch_heap[0];
+
+        prvTMAN_WatchRemove(task);
+        task->LATE = 1;
+        taskEXIT_CRITICAL();
+
+        prvTMAN_SeqBegin(&task->RELEASE_SEQ);
+        task->DEADLINE_MISSES++;
+        prvTMAN_SeqEnd(&task->RELEASE_SEQ);
+        TMAN_TRACE_EVENT(TMAN_TRACE_DEADLINE_MISS, task, 0);
+
+        switch (task->OVERRUN_POLICY) {
+            case TMAN_OVERRUN_SKIP:
+                task->SKIP_NEXT = 1;
+                break;
+            case TMAN_OVERRUN_ABORT:
+                task->ABORT = 1;
+                break;
+            case TMAN_OVERRUN_HANDLER:
+                if (task->OVERRUN_HANDLER != NULL)
+                    task->OVERRUN_HANDLER(task);
+                break;
+            default:
+                break;
+        }
+        taskENTER_CRITICAL();
+    }
+    if (tman_watch_size > 0)
+        next = tman_watch_heap[0]->DEADLINE_AT;
+    taskEXIT_CRITICAL();
+
+    return next;
+}
+
+/* Demote or suspend the jobs that used up their budget. Runs above every
+ * job, so the context switch hooks have already brought JOB_EXEC up to
+ * date. Jobs with budget left are looked at again when they could have
+ * used it up. */
+static void prvTMAN_CheckBudgets(uint64_t kernel) {
+
+    taskENTER_CRITICAL();
+    while (tman_budget_size > 0 && tman_budget_heap[0]->BUDGET_AT <= kernel) {
+        task_tman *task = tman_budget_heap[0];
+        uint32_t limit = task->BUDGET * TMAN_COUNTS_PER_US;
+        uint32_t used = task->JOB_ACTIVE ? task->JOB_EXEC : 0;
+
+        prvTMAN_BudgetRemove(task);
+        if (used < limit) {
+            prvTMAN_BudgetInsert(task, kernel + prvTMAN_UsToTicks((limit - used) / TMAN_COUNTS_PER_US));
+            continue;
+        }
+        // Not inside a critical section: the job would block the others
+        // with the resource. Throttled on the first tick after it unlocks.
+        if (task->LOCKS > 0) {
+            prvTMAN_BudgetInsert(task, kernel + 1);
+            continue;
+        }
+
+        int policy = task->BUDGET_POLICY;
+        task->THROTTLED = 1 + policy;
+        // Out of the deadline queue, so it does not get the EDF priority back
+        if (policy == TMAN_BUDGET_DEMOTE && task->EDF_INDEX >= 0) {
+            prvTMAN_EdfRemove(task);
+            prvTMAN_EdfDispatch();
+        }
+        taskEXIT_CRITICAL();
+
+        prvTMAN_SeqBegin(&task->RELEASE_SEQ);
+        task->BUDGET_OVERRUNS++;
+        prvTMAN_SeqEnd(&task->RELEASE_SEQ);
+
+        if (task->TASK_HANDLE != NULL && policy == TMAN_BUDGET_SUSPEND) {
+            vTaskSuspend(task->TASK_HANDLE);
+        } else if (task->TASK_HANDLE != NULL) {
+            if (!(tman_mode & TMAN_MODE_EDF))
+                task->SAVED_PRIORITY = uxTaskPriorityGet(task->TASK_HANDLE);
+            vTaskPrioritySet(task->TASK_HANDLE, TMAN_BUDGET_PRIORITY);
+        }
+        taskENTER_CRITICAL();
+    }
+    taskEXIT_CRITICAL();
+}
+
+/* Queue one release for each triggered sporadic task, no earlier than one
+ * minimum inter-arrival time (its PERIOD) after the previous release.
+ * Triggers that find a release already queued are merged into it. */
+static void prvTMAN_Triggers(tman_time_t now) {
+
+    for (int w = 0; w < TMAN_TT_MASK_WORDS; w++) {
+        if (tman_trigger_mask[w] == 0)
+            continue;
+
+        taskENTER_CRITICAL();
+        uint32_t mask = tman_trigger_mask[w];
+        tman_trigger_mask[w] = 0;
+        taskEXIT_CRITICAL();
+
+        while (mask != 0) {
+            task_tman *task = &tman_task_list[w * 32 + __builtin_ctz(mask)];
+            int deferred = 0;
+            mask &= mask - 1;
+
+            taskENTER_CRITICAL();
+            if (!task->IN_USE || !task->SPORADIC || task->PAUSED) {
+                // Paused or no longer sporadic: the trigger is ignored
+            } else if (task->HEAP_INDEX >= 0) {
+                task->MERGED_TRIGGERS++;
+            } else {
+                tman_time_t earliest = task->RELEASE_COUNT > 0 ? task->LAST_ACTIVATION + task->PERIOD : now;
+                deferred = earliest > now;
+                task->NEXT_RELEASE = deferred ? earliest : now;
+                task->PENDING_STAMP = deferred ? 0 : task->TRIGGER_STAMP;
+                task->HEAP_INDEX = tman_heap_size;
+                tman_heap[tman_heap_size++] = task;
+                prvTMAN_HeapUp(task->HEAP_INDEX);
+            }
+            taskEXIT_CRITICAL();
+
+            if (deferred) {
+                prvTMAN_SeqBegin(&task->RELEASE_SEQ);
+                task->DEFERRED_RELEASES++;
+                prvTMAN_SeqEnd(&task->RELEASE_SEQ);
+            }
+        }
+    }
+}
+
+/* Release the due tasks of the next-release queue, returns the next release */
+static tman_time_t prvTMAN_ReleaseQueue(uint64_t kernel) {
+    tman_time_t next = TMAN_TIME_NEVER;
+
+    taskENTER_CRITICAL();
+    while (tman_heap_size > 0 && tman_heap[0]->NEXT_RELEASE * tman_period <= kernel) {
+        task_tman *task = tman_heap[0];
+        tman_time_t release = task->NEXT_RELEASE;
+
+        if (task->SPORADIC) {
+            prvTMAN_HeapRemove(task);
+        } else {
+            task->NEXT_RELEASE += task->PERIOD;
+            prvTMAN_HeapDown(0);
+        }
+        taskEXIT_CRITICAL();
+
+        prvTMAN_Release(task, release);
+        taskENTER_CRITICAL();
+    }
+    if (tman_heap_size > 0)
+        next = tman_heap[0]->NEXT_RELEASE;
+    taskEXIT_CRITICAL();
+
+    return next;
+}
+
+/* Release the due entries of the time-triggered table, returns the next release */
+static tman_time_t prvTMAN_ReleaseTable(uint64_t kernel) {
+
+    while (tman_tt_count > 0) {
+        tman_tt_entry *entry = &tman_tt_table[tman_tt_pos];
+        tman_time_t release = tman_tt_base + entry->OFFSET;
+
+        if (release * tman_period > kernel)
+            return release;
+
+        for (int w = 0; w < TMAN_TT_MASK_WORDS; w++) {
+            uint32_t mask = entry->MASK[w];
+            while (mask != 0) {
+                task_tman *task = tman_tt_order[w * 32 + __builtin_ctz(mask)];
+                mask &= mask - 1;
+                // PHASE may exceed PERIOD, skip the releases before the first one
+                if (task != NULL && !task->PAUSED && release >= task->ORIGIN + task->PHASE)
+                    prvTMAN_Release(task, release);
+            }
+        }
+
+        if (++tman_tt_pos == tman_tt_count) {
+            tman_tt_pos = 0;
+            tman_tt_base += tman_tt_hyperperiod;
+
+            // Task set changed: phases now count from this boundary
+            if (tman_tt_dirty && TMAN_TableBuild() != TMAN_SUCCESS) {
+                printf("TMAN: schedule table overflow, using the release queue\n\r");
+                taskENTER_CRITICAL();
+                tman_mode &= ~TMAN_MODE_TIME_TRIGGERED;
+                prvTMAN_ScheduleAll(tman_tt_base);
+                taskEXIT_CRITICAL();
+                return prvTMAN_ReleaseQueue(kernel);
+            }
+        }
+    }
+
+    return TMAN_TIME_NEVER;
+}
+
+/* LCM of the periods of the tasks being released (1 if there are none),
+ * 0 if it does not fit 32 bits */
+static uint64_t prvTMAN_Hyperperiod(void) {
+    uint64_t hyperperiod = 1;
+
+    for (int i = 0; i < TMAN_MAX_TASKS; i++) {
+        task_tman *task = &tman_task_list[i];
+        if (!task->IN_USE || task->PAUSED || task->PERIOD <= 0 || task->SPORADIC)
+            continue;
+        hyperperiod = hyperperiod / prvTMAN_Gcd(hyperperiod, task->PERIOD) * task->PERIOD;
+        if (hyperperiod > UINT32_MAX)
+            return 0;
+    }
+
+    return hyperperiod;
+}
+
+/* Has every job released so far completed? */
+static int prvTMAN_Idle(void) {
+    for (int i = 0; i < TMAN_MAX_TASKS; i++) {
+        if (tman_task_list[i].IN_USE && tman_task_list[i].OUTSTANDING > 0)
+            return 0;
+    }
+    return 1;
+}
+
+/* Put a mode in force from now on: tasks outside it are paused, the
+ * others take its attributes and precedences, with phases counted from
+ * now. Called at an idle instant, so no job, join token or deadline of the
+ * old mode is pending, and in one critical section, so the release queue
+ * never holds a mix of both modes. */
+static void prvTMAN_ModeApply(tman_opmode *mode, tman_time_t now) {
+
+    taskENTER_CRITICAL();
+    for (int i = 0; i < TMAN_MAX_TASKS; i++) {
+        task_tman *task = &tman_task_list[i];
+        if (!task->IN_USE)
+            continue;
+        task->PAUSED = 1;
+        task->SKIP_NEXT = 0;
+        task->NUM_PREDECESSORS = 0;
+        task->NUM_SUCCESSORS = 0;
+        task->READY_EDGES = 0;
+        // A sporadic release held back stays queued if the task is kept
+        if (!task->SPORADIC)
+            prvTMAN_HeapRemove(task);
+    }
+
+    for (int k = 0; k < mode->COUNT; k++) {
+        tman_mode_entry *entry = &mode->TASKS[k];
+        task_tman *task = entry->TASK;
+
+        task->PERIOD = entry->PERIOD;
+        task->PHASE = entry->PHASE;
+        task->DEADLINE = entry->DEADLINE;
+        task->WCET = entry->WCET;
+        task->ORIGIN = now;
+        task->PAUSED = 0;
+        if (entry->PREDECESSOR != NULL) {
+            task->EDGE_TOKENS[task->NUM_PREDECESSORS] = 0;
+            task->PREDECESSORS[task->NUM_PREDECESSORS++] = entry->PREDECESSOR;
+            entry->PREDECESSOR->SUCCESSORS[entry->PREDECESSOR->NUM_SUCCESSORS++] = task;
+        }
+    }
+
+    for (int i = 0; i < TMAN_MAX_TASKS; i++) {
+        if (tman_task_list[i].IN_USE && tman_task_list[i].PAUSED)
+            prvTMAN_HeapRemove(&tman_task_list[i]);
+    }
+    for (int k = 0; k < mode->COUNT; k++)
+        prvTMAN_Schedule(mode->TASKS[k].TASK, now);
+    tman_mode_origin = now;
+    taskEXIT_CRITICAL();
+
+    // Joins given for the old precedences
+    for (int k = 0; k < mode->COUNT; k++) {
+        if (mode->TASKS[k].TASK->JOIN != NULL)
+            xQueueReset(mode->TASKS[k].TASK->JOIN);
+    }
+
+    if (!tman_running)
+        return;
+
+    if (tman_mode & TMAN_MODE_TIME_TRIGGERED) {
+        if (TMAN_TableBuild() == TMAN_SUCCESS) {
+            tman_tt_base = now;
+        } else {
+            printf("TMAN: schedule table overflow, using the release queue\n\r");
+            taskENTER_CRITICAL();
+            tman_mode &= ~TMAN_MODE_TIME_TRIGGERED;
+            prvTMAN_ScheduleAll(now);
+            taskEXIT_CRITICAL();
+        }
+    }
+
+    if ((tman_mode & TMAN_MODE_ASSIGN_MASK) && !(tman_mode & TMAN_MODE_EDF)
+            && TMAN_AssignPriorities(tman_mode) != TMAN_SUCCESS)
+        printf("TMAN: priority assignment incomplete\n\r");
+    prvTMAN_ResourceCeilings();
+}
+
+/* Switch to the pending mode if its safe point has come, or give up on it
+ * after max_wait. Returns the next instant to try, TMAN_TIME_NEVER if no
+ * switch is pending. */
+static tman_time_t prvTMAN_ModeCheck(tman_time_t now) {
+
+    if (tman_mode_status.PENDING < 0)
+        return TMAN_TIME_NEVER;
+
+    if (now >= tman_switch_expires) {
+        taskENTER_CRITICAL();
+        tman_mode_status.PENDING = -1;
+        tman_mode_status.TIMEOUTS++;
+        taskEXIT_CRITICAL();
+        return TMAN_TIME_NEVER;
+    }
+
+    if (now < tman_switch_at)
+        return tman_switch_at < tman_switch_expires ? tman_switch_at : tman_switch_expires;
+
+    if (!prvTMAN_Idle()) {
+        // A boundary with a job pending: try the next one. Idle instants
+        // are tried on every wake, the last job to complete wakes the
+        // dispatcher.
+        if (tman_switch_when == TMAN_SWITCH_HYPERPERIOD)
+            tman_switch_at += tman_switch_hyperperiod;
+        return tman_switch_at > now && tman_switch_at < tman_switch_expires ? tman_switch_at : tman_switch_expires;
+    }
+
+    uint32_t start = TMAN_TIMESTAMP();
+    int mode = tman_mode_status.PENDING;
+    prvTMAN_ModeApply(&tman_opmodes[mode], now);
+    uint32_t apply = (TMAN_TIMESTAMP() - start) / TMAN_COUNTS_PER_US;
+    uint32_t latency = now - tman_switch_requested;
+
+    taskENTER_CRITICAL();
+    tman_mode_status.CURRENT = mode;
+    tman_mode_status.PENDING = -1;
+    tman_mode_status.SWITCHES++;
+    tman_mode_status.LATENCY_LAST = latency;
+    if (latency > tman_mode_status.LATENCY_MAX)
+        tman_mode_status.LATENCY_MAX = latency;
+    if (apply > tman_mode_status.APPLY_MAX)
+        tman_mode_status.APPLY_MAX = apply;
+    taskEXIT_CRITICAL();
+
+    return TMAN_TIME_NEVER;
+}
+
+#if TMAN_TRACE || TMAN_LOG
+/* Console task, at idle priority so that no job ever waits for the UART.
+ * Prints the TMAN_Log() messages, then streams the trace ring as one
+ * text line per item so it survives PrintStr():
+ *   H<hz>                     timestamp frequency, once
+ *   N<task> <name>            name of a task, on its TMAN_TRACE_ADD
+ *   R<stamp><task><event><arg> one record, fixed-width hex
+ *   D<dropped>                records lost so far, when it grows */
+static void prvTMAN_Console(void *pvParam) {
+    uint8_t line[TMAN_LOG_LINE];
+#if TMAN_LOG
+    uint32_t log_dropped = 0;
+    tman_log_record message;
+#endif
+#if TMAN_TRACE
+    uint32_t trace_dropped = 0;
+    tman_trace_record record;
+
+    sprintf(line, "H%lu\n\r", (unsigned long) TMAN_TIMESTAMP_HZ);
+    PrintStr(line);
+#endif
+
+    for (;;) {
+#if TMAN_LOG
+        while (TMAN_LogGet(&message)) {
+            int len = sprintf(line, "[%lu] ", (unsigned long) (message.STAMP / TMAN_COUNTS_PER_US));
+            snprintf(line + len, sizeof(line) - len, message.FORMAT, message.ARGS[0],
+                     message.ARGS[1], message.ARGS[2], message.ARGS[3]);
+            PrintStr(line);
+        }
+
+        if (TMAN_LogDropped() != log_dropped) {
+            log_dropped = TMAN_LogDropped();
+            sprintf(line, "TMAN_Log: %lu messages dropped\n\r", (unsigned long) log_dropped);
+            PrintStr(line);
+        }
+#endif
+#if TMAN_TRACE
+        while (TMAN_TraceRead(&record)) {
+            if (record.EVENT == TMAN_TRACE_ADD) {
+                sprintf(line, "N%04x %s\n\r", record.TASK, tman_task_list[record.TASK].NAME);
+                PrintStr(line);
+            }
+            sprintf(line, "R%08lx%04x%02x%02x\n\r", (unsigned long) record.STAMP,
+                    record.TASK, record.EVENT, record.ARG);
+            PrintStr(line);
+        }
+
+        if (TMAN_TraceDropped() != trace_dropped) {
+            trace_dropped = TMAN_TraceDropped();
+            sprintf(line, "D%lu\n\r", (unsigned long) trace_dropped);
+            PrintStr(line);
+        }
+#endif
+
+        vTaskDelay(TMAN_CONSOLE_PERIOD_MS / portTICK_RATE_MS);
+    }
+}
+#endif
+
+void pvTMAN_Task(void *pvParam) {
+    vTaskDelay(1);
+
+    // Longest sleep that still fits a kernel TickType_t delay
+    const uint64_t max_sleep = portMAX_DELAY / 2;
+
+    tman_kernel_base = xTaskGetTickCount();
+    tman_kernel_epoch = 0;
+
+    if ((tman_mode & TMAN_MODE_TIME_TRIGGERED) && TMAN_TableBuild() != TMAN_SUCCESS) {
+        printf("TMAN: schedule table overflow, using the release queue\n\r");
+        tman_mode &= ~TMAN_MODE_TIME_TRIGGERED;
+    }
+
+    // Runs above every task, so nothing executes with a stale priority
+    if ((tman_mode & TMAN_MODE_ASSIGN_MASK) && !(tman_mode & TMAN_MODE_EDF)
+            && TMAN_AssignPriorities(tman_mode) != TMAN_SUCCESS)
+        printf("TMAN: priority assignment incomplete\n\r");
+    prvTMAN_ResourceCeilings();
+
+    taskENTER_CRITICAL();
+    prvTMAN_ScheduleAll(0);
+    tman_running = 1;
+    taskEXIT_CRITICAL();
+
+    for (;;) {
+        uint64_t kernel = prvTMAN_KernelTime();
+        tman_ticks = kernel / tman_period;
+
+        // Mode change first: releases due at the switch instant already
+        // belong to the new mode
+        tman_time_t change = prvTMAN_ModeCheck(tman_ticks);
+
+        // Deadlines first: a job due at the instant of the next
+        // release of its task is already late
+        tman_time_t deadline = prvTMAN_CheckDeadlines(kernel);
+
+        // Budgets before releases too: a job spent at a release instant
+        // is throttled, then goes on with the budget of that release
+        prvTMAN_CheckBudgets(kernel);
+
+        // Release only the tasks that are due. Sporadic releases always
+        // go through the queue.
+        prvTMAN_Triggers(tman_ticks);
+        tman_time_t next = prvTMAN_ReleaseQueue(kernel);
+        if (tman_mode & TMAN_MODE_TIME_TRIGGERED) {
+            tman_time_t table = prvTMAN_ReleaseTable(kernel);
+            if (table < next)
+                next = table;
+        }
+        if (deadline < next)
+            next = deadline;
+        if (change < next)
+            next = change;
+
+        // Sleep straight until the earliest pending release or deadline
+        uint64_t wait = max_sleep;
+        if (next != TMAN_TIME_NEVER && next * tman_period - kernel < wait)
+            wait = next * tman_period - kernel;
+
+        // Budgets are watched on kernel ticks, finer than the TMAN tick
+        taskENTER_CRITICAL();
+        uint64_t budget = tman_budget_size > 0 ? tman_budget_heap[0]->BUDGET_AT : TMAN_TIME_NEVER;
+        taskEXIT_CRITICAL();
+        if (budget <= kernel)
+            wait = 0;
+        else if (budget - kernel < wait)
+            wait = budget - kernel;
+
+        // Set TMAN_SELFTEST_TICKS to 0 to skip testing TMAN_TaskStats()
+        if (TMAN_SELFTEST_TICKS > 0 && tman_ticks > TMAN_SELFTEST_TICKS) {
+            PrintStr("Testing TMAN_TaskStats(\"B\") - tman.c line 61\n\r");
+            
+            tman_stats_t stats;
+            uint8_t message[80];
+            if (TMAN_TaskStatsEx(TMAN_TaskGetHandle("B"), &stats) == TMAN_SUCCESS) {
+                sprintf(message, "Task %s - N. Activations: %lu - Deadline Misses: %lu\n\r", "B",
+                        (unsigned long) stats.ACTIVATIONS, (unsigned long) stats.DEADLINE_MISSES);
+                PrintStr(message);
+                sprintf(message, "Task %s - Response time: %lu/%lu/%lu us (min/avg/max)\n\r", "B",
+                        (unsigned long) stats.RESPONSE_MIN, (unsigned long) stats.RESPONSE_AVG,
+                        (unsigned long) stats.RESPONSE_MAX);
+                PrintStr(message);
+                sprintf(message, "Task %s - Releases queued/coalesced/dropped: %lu/%lu/%lu\n\r", "B",
+                        (unsigned long) stats.QUEUED_RELEASES, (unsigned long) stats.COALESCED_RELEASES,
+                        (unsigned long) stats.DROPPED_RELEASES);
+                PrintStr(message);
+                sprintf(message, "Task %s - Budget overruns: %lu\n\r", "B",
+                        (unsigned long) stats.BUDGET_OVERRUNS);
+                PrintStr(message);
+            }
+#if TMAN_RESPONSE_HISTOGRAM
+            uint32_t p99;
+            if (TMAN_TaskGetResponseQuantile(TMAN_TaskGetHandle("B"), 9900, &p99) == TMAN_SUCCESS) {
+                sprintf(message, "Task %s - Response time p99: %lu us\n\r", "B", (unsigned long) p99);
+                PrintStr(message);
+            }
+#endif
+#if INCLUDE_uxTaskGetStackHighWaterMark == 1
+            sprintf(message, "TMAN - Dispatcher stack: %lu of %lu words never used\n\r",
+                    (unsigned long) uxTaskGetStackHighWaterMark(NULL), (unsigned long) TMAN_DISPATCHER_STACK);
+            PrintStr(message);
+#endif
+            TMAN_Close();
+        }
+
+        // A notification (attribute change) wakes the dispatcher early
+        ulTaskNotifyTake(pdTRUE, (TickType_t) wait);
+    }
+}
+
+/********************************************************************
+ * Function: 	TMAN_Init()
+ * Precondition: 
+ * Input: 		 tick_ms
+ * Returns:      TMAN_SUCCESS if Ok.
+ * Side Effects:	 
+ * Overview:     Initializes Task Manager Framework.
+ *		
+ * Note:		 	
+ * 
+ ********************************************************************/
+
+int TMAN_Init(int tick_ms) {
+    return TMAN_InitMode(tick_ms, TMAN_MODE_EVENT);
+}
+
+/********************************************************************
+ * Function: 	TMAN_InitMode()
+ * Precondition: 
+ * Input: 		 tick_ms, mode (TMAN_MODE_* flags, see tman.h)
+ * Returns:      TMAN_SUCCESS if Ok.
+ * Side Effects:	 
+ * Overview:     Initializes Task Manager Framework in the given mode.
+ *		
+ * Note:		 	In TMAN_MODE_TIME_TRIGGERED the release table is built
+ *               when the dispatcher starts, from the tasks registered
+ *               by then. Call TMAN_TableBuild() first to check that
+ *               the task set fits.
+ *               TMAN_MODE_EDF (may be combined with the above) ignores
+ *               the priorities given to xTaskCreate(): each job gets
+ *               the absolute deadline release + DEADLINE and the
+ *               earliest one runs at TMAN_EDF_PRIORITY_HIGH.
+ *               TMAN_MODE_ASSIGN_* replace those priorities with
+ *               TMAN_AssignPriorities() when the dispatcher starts.
+ * 
+ ********************************************************************/
+
+int TMAN_InitMode(int tick_ms, int mode) {
+    
+    tman_mode = mode;
+    tman_period = tick_ms;
+    xTaskCreate(pvTMAN_Task, (const signed char * const) "TMAN", 
+                TMAN_DISPATCHER_STACK, NULL, TMAN_PRIORITY, &tman_handle);
+#if TMAN_TRACE || TMAN_LOG
+    xTaskCreate(prvTMAN_Console, (const signed char * const) "CONS", 
+                2 * configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY, NULL);
+#endif
+    
+    return TMAN_SUCCESS;
+    
+}
+
+/********************************************************************
+ * Function: 	TMAN_Close()
+ * Precondition: 
+ * Input: 		
+ * Returns:      TMAN_SUCCESS if Ok.
+ * Side Effects:	 
+ * Overview:     Terminates Task Manager Framework.
+ *		
+ * Note:		 	Ends the scheduler
+ * 
+ ********************************************************************/
+
+int TMAN_Close(){
+
+    vTaskEndScheduler();
+    
+    return TMAN_SUCCESS;
+}
+
+/* Topological order of the tasks in use (Kahn), predecessors first */
+static int prvTMAN_TopoOrder(task_tman *order[]) {
+    static int pending[TMAN_MAX_TASKS];
+    int n = 0;
+
+    for (int i = 0; i < TMAN_MAX_TASKS; i++) {
+        if (!tman_task_list[i].IN_USE)
+            continue;
+        pending[i] = tman_task_list[i].NUM_PREDECESSORS;
+        if (pending[i] == 0)
+            order[n++] = &tman_task_list[i];
+    }
+
+    for (int head = 0; head < n; head++) {
+        task_tman *task = order[head];
+        for (int k = 0; k < task->NUM_SUCCESSORS; k++) {
+            task_tman *succ = task->SUCCESSORS[k];
+            if (--pending[succ - tman_task_list] == 0)
+                order[n++] = succ;
+        }
+    }
+
+    return n;
+}
+
+/* Is target reachable from task through successor edges? (iterative DFS) */
+static int prvTMAN_Reaches(task_tman *task, task_tman *target) {
+    static task_tman *stack[TMAN_MAX_TASKS];
+    int top = 0;
+
+    tman_visit_mark++;
+    task->VISIT_MARK = tman_visit_mark;
+    stack[top++] = task;
+
+    while (top > 0) {
+        task_tman *node = stack[--top];
+        if (node == target)
+            return 1;
+        for (int k = 0; k < node->NUM_SUCCESSORS; k++) {
+            task_tman *succ = node->SUCCESSORS[k];
+            if (succ->VISIT_MARK != tman_visit_mark) {
+                succ->VISIT_MARK = tman_visit_mark;
+                stack[top++] = succ;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/* A job of task completed: hand one token to each dependent and release
+ * the joins whose predecessors have all completed */
+static void prvTMAN_Complete(task_tman *task) {
+
+    for (int i = 0; i < task->NUM_SUCCESSORS; i++) {
+        task_tman *succ = task->SUCCESSORS[i];
+        int fire;
+
+        taskENTER_CRITICAL();
+        for (int k = 0; k < succ->NUM_PREDECESSORS; k++) {
+            if (succ->PREDECESSORS[k] == task && succ->EDGE_TOKENS[k]++ == 0)
+                succ->READY_EDGES++;
+        }
+        fire = succ->READY_EDGES == succ->NUM_PREDECESSORS;
+        if (fire) {
+            for (int k = 0; k < succ->NUM_PREDECESSORS; k++) {
+                if (--succ->EDGE_TOKENS[k] == 0)
+                    succ->READY_EDGES--;
+            }
+        }
+        taskEXIT_CRITICAL();
+
+        if (fire) {
+            xSemaphoreGive(succ->JOIN);
+            // A job does not wait on the join, its executor tries again
+            if (succ->JOB_FN != NULL)
+                prvTMAN_JobReady(succ);
+        }
+    }
+}
+
+/********************************************************************
+ * Function: 	TMAN_TableBuild()
+ * Precondition: Task set registered, called before vTaskStartScheduler()
+ * Input: 		
+ * Returns:      TMAN_SUCCESS if Ok.
+ *               TMAN_FAIL_TABLE_OVERFLOW if the hyperperiod does not fit
+ *               32 bits or has more than TMAN_TT_TABLE_SIZE release
+ *               instants.
+ * Side Effects:	 
+ * Overview:     Precompute the time-triggered release table: one
+ *               (offset, task bitmask) entry per release instant over
+ *               the hyperperiod (LCM of the periods). Within an entry,
+ *               predecessors are released before their dependents.
+ *		
+ * Note:		 	
+ * 
+ ********************************************************************/
+
+int TMAN_TableBuild(void) {
+
+    uint64_t hyperperiod = 1;
+    int n = 0;
+
+    // Keep the periodic tasks, in precedence order
+    int total = prvTMAN_TopoOrder(tman_tt_order);
+    for (int i = 0; i < total; i++) {
+        task_tman *task = tman_tt_order[i];
+        task->TT_INDEX = -1;
+        if (task->PERIOD <= 0 || task->SPORADIC)
+            continue;
+        tman_tt_order[n++] = task;
+
+        hyperperiod = hyperperiod / prvTMAN_Gcd(hyperperiod, task->PERIOD) * task->PERIOD;
+        if (hyperperiod > UINT32_MAX)
+            return TMAN_FAIL_TABLE_OVERFLOW;
+    }
+
+    // Merge every release over the hyperperiod into the sorted table
+    int count = 0;
+    for (int k = 0; k < n; k++) {
+        task_tman *task = tman_tt_order[k];
+        task->TT_INDEX = k;
+
+        for (uint64_t t = task->PHASE % task->PERIOD; t < hyperperiod; t += task->PERIOD) {
+            int lo = 0, hi = count;
+            while (lo < hi) {
+                int mid = (lo + hi) / 2;
+                if (tman_tt_table[mid].OFFSET < t)
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            if (lo == count || tman_tt_table[lo].OFFSET != t) {
+                if (count == TMAN_TT_TABLE_SIZE)
+                    return TMAN_FAIL_TABLE_OVERFLOW;
+                memmove(&tman_tt_table[lo + 1], &tman_tt_table[lo], (count - lo) * sizeof(tman_tt_entry));
+                memset(&tman_tt_table[lo], 0, sizeof(tman_tt_entry));
+                tman_tt_table[lo].OFFSET = t;
+                count++;
+            }
+            tman_tt_table[lo].MASK[k / 32] |= 1UL << (k % 32);
+        }
+    }
+
+    tman_tt_count = count;
+    tman_tt_hyperperiod = hyperperiod;
+    tman_tt_pos = 0;
+    tman_tt_dirty = 0;
+
+    return TMAN_SUCCESS;
+}
+
+/* Take a slot from the free list for a task, or a job if fn is set.
+ * NULL if the name is taken: the check and IN_USE are set in the same
+ * critical section, two tasks adding one name cannot both get a slot. */
+static task_tman *prvTMAN_Add(char taskName[], tman_job_fn_t fn, void *arg) {
+    task_tman *task = NULL;
+
+    taskENTER_CRITICAL();
+    if (!tman_list_ready)
+        prvTMAN_ListInit();
+
+    // Compared as stored, a longer name would alias its truncation
+    int taken = 0;
+    for (int i = 0; i < TMAN_MAX_TASKS && !taken; i++)
+        taken = tman_task_list[i].IN_USE
+                && strncmp(tman_task_list[i].NAME, taskName, sizeof(tman_task_list[i].NAME) - 1) == 0;
+
+    if (!taken && tman_free_list != NULL) {
+        task = tman_free_list;
+        tman_free_list = task->NEXT_FREE;
+
+        memset(task, 0, sizeof(*task));
+        strncpy(task->NAME, taskName, sizeof(task->NAME) - 1);
+        task->HEAP_INDEX = -1;
+        task->EDF_INDEX = -1;
+        task->WATCH_INDEX = -1;
+        task->BUDGET_INDEX = -1;
+        task->TT_INDEX = -1;
+        task->BACKLOG_DEPTH = TMAN_BACKLOG_DEPTH;
+        task->JOB_FN = fn;
+        task->JOB_ARG = arg;
+        task->IN_USE = 1;
+    }
+    taskEXIT_CRITICAL();
+
+    if (task == NULL)
+        return NULL;
+
+    prvTMAN_Bind(task, xTaskGetHandle(taskName));
+    TMAN_TRACE_EVENT(TMAN_TRACE_ADD, task, 0);
+    printf("Task <%s> adicionada.\n\r", taskName);
+    return task;
+}
+
+/********************************************************************
+ * Function: 	TMAN_TaskAdd()
+ * Precondition: 
+ * Input:        taskName 
+ * Returns:      Handle of the task if Ok.
+ *               NULL if the task list is full or a task or job with
+ *               the same name (first 15 characters) was already added.
+ * Side Effects:	 
+ * Overview:     Add a task to the framework.
+ *		
+ * Note:		 	Takes a slot from the free list, after a linear check
+ *               that the name is not taken: the string API and the
+ *               kernel binding look tasks up by name. The kernel handle
+ *               is cached here if the FreeRTOS task already exists,
+ *               otherwise on its first wait.
+ * 
+ ********************************************************************/
+
+tman_handle_t TMAN_TaskAdd(char taskName[]) {
+    return prvTMAN_Add(taskName, NULL, NULL);
+}
+
+/********************************************************************
+ * Function: 	TMAN_TaskRemove()
+ * Precondition: No other task has this one as PRECEDENCE, no mode lists it
+ * Input:        task handle 
+ * Returns:      TMAN_SUCCESS if Ok.
+ *               TMAN_FAIL_TASK_NOT_ADDED if the handle is not in use
+ *               TMAN_FAIL_TASK_IN_USE if other tasks depend on it, a
+ *                                     mode lists it or it is declared
+ *                                     on a resource
+ * Side Effects:	 The handle must not be used afterwards, its slot is
+ *               reused by the next TMAN_TaskAdd().
+ * Overview:     Remove a task from the framework.
+ *		
+ * Note:		 	O(log n). The FreeRTOS task itself is not deleted, only
+ *               untagged.
+ * 
+ ********************************************************************/
+
+int TMAN_TaskRemove(tman_handle_t task) {
+
+    if (task == NULL || !task->IN_USE)
+        return TMAN_FAIL_TASK_NOT_ADDED;
+    if (task->NUM_SUCCESSORS > 0)
+        return TMAN_FAIL_TASK_IN_USE;
+    for (int m = 0; m < TMAN_MAX_MODES; m++) {
+        for (int k = 0; k < tman_opmodes[m].COUNT; k++) {
+            if (tman_opmodes[m].TASKS[k].TASK == task)
+                return TMAN_FAIL_TASK_IN_USE;
+        }
+    }
+    for (int r = 0; r < TMAN_MAX_RESOURCES; r++) {
+        for (int k = 0; k < tman_resources[r].NUM_USERS; k++) {
+            if (tman_resources[r].USERS[k] == task)
+                return TMAN_FAIL_TASK_IN_USE;
+        }
+    }
+
+    // The kernel task outlives the slot: its context switches must not
+    // be charged to the next task added there
+#if configUSE_APPLICATION_TASK_TAG == 1
+    if (task->TASK_HANDLE != NULL)
+        vTaskSetApplicationTaskTag(task->TASK_HANDLE, NULL);
+#endif
+    task->TASK_HANDLE = NULL;
+
+    taskENTER_CRITICAL();
+    prvTMAN_HeapRemove(task);
+    prvTMAN_WatchRemove(task);
+    prvTMAN_BudgetRemove(task);
+    if (task->JOB_FN != NULL) {
+        int slot = task - tman_task_list;
+        tman_executors[task->BAND].READY[slot / 32] &= ~(1u << (slot % 32));
+    }
+    if (task->EDF_INDEX >= 0) {
+        prvTMAN_EdfRemove(task);
+        prvTMAN_EdfDispatch();
+    }
+    if (task->TT_INDEX >= 0)
+        tman_tt_order[task->TT_INDEX] = NULL;
+    // Unlink from the successor lists of its predecessors
+    for (int k = 0; k < task->NUM_PREDECESSORS; k++) {
+        task_tman *pred = task->PREDECESSORS[k];
+        for (int j = 0; j < pred->NUM_SUCCESSORS; j++) {
+            if (pred->SUCCESSORS[j] == task) {
+                pred->SUCCESSORS[j] = pred->SUCCESSORS[--pred->NUM_SUCCESSORS];
+                break;
+            }
+        }
+    }
+    task->IN_USE = 0;
+    task->NEXT_FREE = tman_free_list;
+    tman_free_list = task;
+    taskEXIT_CRITICAL();
+
+    if (task->JOIN != NULL) {
+        vSemaphoreDelete(task->JOIN);
+        task->JOIN = NULL;
+    }
+
+    return TMAN_SUCCESS;
+}
+
+/********************************************************************
+ * Function: 	TMAN_TaskPause()
+ * Precondition: 
+ * Input:        task handle 
+ * Returns:      TMAN_SUCCESS if Ok.
+ *               TMAN_FAIL_TASK_NOT_ADDED if the handle is not in use
+ * Side Effects:	 
+ * Overview:     Stop releasing a task until TMAN_TaskResume().
+ *		
+ * Note:		 	A job already released still runs to completion.
+ * 
+ ********************************************************************/
+
+int TMAN_TaskPause(tman_handle_t task) {
+
+    if (task == NULL || !task->IN_USE)
+        return TMAN_FAIL_TASK_NOT_ADDED;
+
+    taskENTER_CRITICAL();
+    task->PAUSED = 1;
+    prvTMAN_HeapRemove(task);
+    taskEXIT_CRITICAL();
+
+    return TMAN_SUCCESS;
+}
+
+/********************************************************************
+ * Function: 	TMAN_TaskResume()
+ * Precondition: 
+ * Input:        task handle 
+ * Returns:      TMAN_SUCCESS if Ok.
+ *               TMAN_FAIL_TASK_NOT_ADDED if the handle is not in use
+ * Side Effects:	 
+ * Overview:     Release a paused task again, from its next
+ *               PERIOD/PHASE instant on.
+ *		
+ * Note:		 	
+ * 
+ ********************************************************************/
+
+int TMAN_TaskResume(tman_handle_t task) {
+
+    if (task == NULL || !task->IN_USE)
+        return TMAN_FAIL_TASK_NOT_ADDED;
+
+    taskENTER_CRITICAL();
+    task->PAUSED = 0;
+    if (tman_running)
+        prvTMAN_Schedule(task, prvTMAN_Now());
+    taskEXIT_CRITICAL();
+
+    if (tman_running)
+        xTaskNotifyGive(tman_handle);
+
+    return TMAN_SUCCESS;
+}
+
+/********************************************************************
+ * Function: 	TMAN_TaskGetHandle()
+ * Precondition: 
+ * Input:        taskName 
+ * Returns:      Handle of the task, NULL if it was not added.
+ * Side Effects:	 
+ * Overview:     Look up the handle of a task added to the framework.
+ *		
+ * Note:		 	Linear search by name, keep it out of the hot path.
+ * 
+ ********************************************************************/
+
+tman_handle_t TMAN_TaskGetHandle(char taskName[]) {
+    return prvTMAN_Find(taskName);
+}
+
+/********************************************************************
+ * Function: 	TMAN_TaskGetName()
+ * Precondition: 
+ * Input:        task handle 
+ * Returns:      Name of the task.
+ * Side Effects:	 
+ * Overview:     Name the task was added with.
+ *		
+ * Note:		 	
+ * 
+ ********************************************************************/
+
+const char * TMAN_TaskGetName(tman_handle_t task) {
+    return task->NAME;
+}
+
+/********************************************************************
+ * Function: 	TMAN_TaskRegisterAttributes()
+ * Precondition: 
+ * Input: 		 taskName, attribute, value of the attribute
+ * Attributes:   PERIOD, PHASE, DEADLINE, PRECEDENCE CONSTRAINTS,
+ *               WCET (in microseconds), OVERRUN (CONTINUE, SKIP or ABORT),
+ *               BACKLOG (queue depth, COALESCE or DROP), BUDGET (CPU
+ *               time per job, in microseconds), MIT (minimum
+ *               inter-arrival time of a sporadic task), BAND (executor
+ *               of a job)
+ * 
+ * Returns:      TMAN_SUCCESS if Ok.
+ *               TMAN_FAIL error code in case of failure (see tman.h)
+ *               TMAN_FAIL_INVALID_ATTRIBUTE if attribute is not valid.
+ *               TMAN_FAIL_TASK_NOT_ADDED if task was not added 
+ *                                        to the framework
+ * Side Effects:	 
+ * Overview:     Register attributes (period, phase, deadline, 
+ *               precedence constraints) for a task already added to 
+ *               the framework.
+ *		
+ * Note:		 	Compatibility wrapper for TMAN_TaskRegisterAttributesEx()
+ * 
+ ********************************************************************/
+
+int TMAN_TaskRegisterAttributes(char taskName[], char attribute[], char value[]){
+    return TMAN_TaskRegisterAttributesEx(prvTMAN_Find(taskName), attribute, value);
+}
+
+/********************************************************************
+ * Function: 	TMAN_TaskRegisterAttributesEx()
+ * Precondition: 
+ * Input: 		 task handle, attribute, value of the attribute
+ * Attributes:   PERIOD, PHASE, DEADLINE, PRECEDENCE CONSTRAINTS, WCET,
+ *               OVERRUN, BACKLOG, BUDGET, MIT
+ * 
+ * Returns:      Same as TMAN_TaskRegisterAttributes()
+ * Side Effects:	 
+ * Overview:     Register attributes for a task already added to 
+ *               the framework. The PRECEDENCE task is resolved once
+ *               here so activations never search by name. Registering
+ *               PRECEDENCE again adds one more predecessor.
+ *		
+ * Note:		 	
+ * 
+ ********************************************************************/
+
+int TMAN_TaskRegisterAttributesEx(tman_handle_t task, char attribute[], char value[]){
+    
+    if (task == NULL || !task->IN_USE)
+        return TMAN_FAIL_TASK_NOT_ADDED;
+
+    if (strcmp(attribute, "PERIOD") == 0) {
+        task->PERIOD = atoi(value);
+        if (!(task->DEADLINE > 0))
+            task->DEADLINE = atoi(value);
+    } else if (strcmp(attribute, "PHASE") == 0) {
+        task->PHASE = atoi(value);
+    } else if (strcmp(attribute, "DEADLINE") == 0) {
+        task->DEADLINE = atoi(value);
+    } else if (strcmp(attribute, "WCET") == 0) {
+        task->WCET = atoi(value);
+        return TMAN_SUCCESS;
+    } else if (strcmp(attribute, "OVERRUN") == 0) {
+        if (strcmp(value, "CONTINUE") == 0)
+            return TMAN_TaskSetOverrunPolicy(task, TMAN_OVERRUN_CONTINUE, NULL);
+        if (strcmp(value, "SKIP") == 0)
+            return TMAN_TaskSetOverrunPolicy(task, TMAN_OVERRUN_SKIP, NULL);
+        if (strcmp(value, "ABORT") == 0)
+            return TMAN_TaskSetOverrunPolicy(task, TMAN_OVERRUN_ABORT, NULL);
+        return TMAN_FAIL_INVALID_ATTRIBUTE;
+    } else if (strcmp(attribute, "BACKLOG") == 0) {
+        if (strcmp(value, "COALESCE") == 0)
+            return TMAN_TaskSetBacklog(task, TMAN_BACKLOG_COALESCE, 1);
+        if (strcmp(value, "DROP") == 0)
+            return TMAN_TaskSetBacklog(task, TMAN_BACKLOG_DROP, 1);
+        return TMAN_TaskSetBacklog(task, TMAN_BACKLOG_QUEUE, atoi(value));
+    } else if (strcmp(attribute, "BUDGET") == 0) {
+        return TMAN_TaskSetBudget(task, atoi(value), task->BUDGET_POLICY);
+    } else if (strcmp(attribute, "MIT") == 0) {
+        return TMAN_TaskSetSporadic(task, atoi(value));
+    } else if (strcmp(attribute, "BAND") == 0) {
+        return TMAN_JobSetBand(task, atoi(value));
+    } else if (strcmp(attribute, "PRECEDENCE") == 0) {
+        // Verify if value is actually a task_name that exists, if not return TMAN_FAIL
+        task_tman *precedence = prvTMAN_Find(value);
+        if (precedence == NULL)
+            return TMAN_FAIL;
+
+        return TMAN_TaskAddPrecedence(task, precedence);
+    } else {
+        return TMAN_FAIL_INVALID_ATTRIBUTE;
+    }
+
+    // Requeue the task and wake the dispatcher if it is already running
+    if (tman_running) {
+        taskENTER_CRITICAL();
+        prvTMAN_Schedule(task, prvTMAN_Now());
+        taskEXIT_CRITICAL();
+        xTaskNotifyGive(tman_handle);
+    }
+    return TMAN_SUCCESS;
+}
+
+/********************************************************************
+ * Function: 	TMAN_TaskAddPrecedence()
+ * Precondition: 
+ * Input: 		 task handle, predecessor handle
+ * Returns:      TMAN_SUCCESS if Ok (also if the edge already exists).
+ *               TMAN_FAIL_TASK_NOT_ADDED if a handle is not in use
+ *               TMAN_FAIL_PRECEDENCE_CYCLE if the edge closes a cycle
+ *               TMAN_FAIL if TMAN_MAX_PREDECESSORS/SUCCESSORS is
+ *                         exceeded or the join semaphore can't be created
+ * Side Effects:	 
+ * Overview:     Each job of task waits until every predecessor has
+ *               completed one more job. Tasks may have several
+ *               predecessors (join) and several dependents (fork).
+ *		
+ * Note:		 	
+ * 
+ ********************************************************************/
+
+int TMAN_TaskAddPrecedence(tman_handle_t task, tman_handle_t predecessor) {
+
+    if (task == NULL || !task->IN_USE || predecessor == NULL || !predecessor->IN_USE)
+        return TMAN_FAIL_TASK_NOT_ADDED;
+
+    for (int k = 0; k < task->NUM_PREDECESSORS; k++) {
+        if (task->PREDECESSORS[k] == predecessor)
+            return TMAN_SUCCESS;
+    }
+
+    if (task->NUM_PREDECESSORS == TMAN_MAX_PREDECESSORS || predecessor->NUM_SUCCESSORS == TMAN_MAX_SUCCESSORS)
+        return TMAN_FAIL;
+
+    // The new edge predecessor -> task closes a cycle if task already reaches predecessor
+    if (prvTMAN_Reaches(task, predecessor))
+        return TMAN_FAIL_PRECEDENCE_CYCLE;
+
+    if (task->JOIN == NULL)
+        task->JOIN = xSemaphoreCreateCounting(TMAN_JOIN_MAX, 0);
+    if (task->JOIN == NULL)
+        return TMAN_FAIL;
+
+    taskENTER_CRITICAL();
+    task->EDGE_TOKENS[task->NUM_PREDECESSORS] = 0;
+    task->PREDECESSORS[task->NUM_PREDECESSORS++] = predecessor;
+    predecessor->SUCCESSORS[predecessor->NUM_SUCCESSORS++] = task;
+    taskEXIT_CRITICAL();
+
+    if (tman_running && (tman_mode & TMAN_MODE_TIME_TRIGGERED))
+        tman_tt_dirty = 1;
+
+    return TMAN_SUCCESS;
+}
+
+/********************************************************************
+ * Function: 	TMAN_TaskSetLoad()
+ * Precondition: 
+ * Input: 		 task set table (see TMAN_TASK_SET() in tman.h), number of
+ *               tasks, handles[] for the handle of each task (may be NULL)
+ * Returns:      TMAN_SUCCESS if Ok.
+ *               TMAN_FAIL_INVALID_ATTRIBUTE if an entry is invalid
+ *               (nothing is registered then)
+ *               TMAN_FAIL_TASK_LIST_FULL if TMAN_MAX_TASKS is exceeded
+ *               TMAN_FAIL if a FreeRTOS task can't be created
+ *               TMAN_TaskAddPrecedence() errors
+ * Side Effects:	 Creates the FreeRTOS task of every entry with a BODY.
+ * Overview:     Register a whole task set in one call: adds each task,
+ *               creates it, sets its attributes and links the
+ *               predecessors, without any string parsing or name
+ *               lookups.
+ *		
+ * Note:		 	Tables built with TMAN_TASK_SET() were already checked
+ *               at compile time, the checks here are for hand-written
+ *               ones. On a later failure the tasks added so far stay.
+ * 
+ ********************************************************************/
+
+int TMAN_TaskSetLoad(const tman_task_def set[], int count, tman_handle_t handles[]) {
+
+    static task_tman *added[TMAN_MAX_TASKS];
+
+    if (count > TMAN_MAX_TASKS)
+        return TMAN_FAIL_TASK_LIST_FULL;
+
+    for (int k = 0; k < count; k++) {
+        const tman_task_def *def = &set[k];
+        if (def->PERIOD <= 0 || def->DEADLINE < 0 || def->DEADLINE > def->PERIOD
+                || def->PRECEDENCE >= count || def->PRECEDENCE == k)
+            return TMAN_FAIL_INVALID_ATTRIBUTE;
+    }
+
+    for (int k = 0; k < count; k++) {
+        const tman_task_def *def = &set[k];
+        task_tman *task = TMAN_TaskAdd((char *) def->NAME);
+
+        if (task == NULL)
+            return TMAN_FAIL_TASK_LIST_FULL;
+        added[k] = task;
+        if (handles != NULL)
+            handles[k] = task;
+
+        if (def->BODY != NULL) {
+            TaskHandle_t handle;
+            if (xTaskCreate(def->BODY, (const signed char * const) def->NAME, configMINIMAL_STACK_SIZE,
+                            (void *) task, def->PRIORITY, &handle) != pdPASS)
+                return TMAN_FAIL;
+            prvTMAN_Bind(task, handle);
+        }
+
+        taskENTER_CRITICAL();
+        task->PERIOD = def->PERIOD;
+        task->PHASE = def->PHASE;
+        task->DEADLINE = def->DEADLINE > 0 ? def->DEADLINE : def->PERIOD;
+        task->WCET = def->WCET;
+        if (tman_running)
+            prvTMAN_Schedule(task, prvTMAN_Now());
+        taskEXIT_CRITICAL();
+    }
+
+    for (int k = 0; k < count; k++) {
+        if (set[k].PRECEDENCE < 0)
+            continue;
+        int err = TMAN_TaskAddPrecedence(added[k], added[set[k].PRECEDENCE]);
+        if (err != TMAN_SUCCESS)
+            return err;
+    }
+
+    if (tman_running)
+        xTaskNotifyGive(tman_handle);
+
+    return TMAN_SUCCESS;
+}
+
+/********************************************************************
+ * Function: 	TMAN_ModeDefine()
+ * Precondition: The tasks of the set were added with TMAN_TaskAdd()
+ * Input: 		 mode (0 .. TMAN_MAX_MODES - 1), task set table (see
+ *               TMAN_TASK_SET() in tman.h), number of tasks
+ * Returns:      TMAN_SUCCESS if Ok.
+ *               TMAN_FAIL_INVALID_ATTRIBUTE if the mode or an entry is
+ *               invalid, or a task is listed twice
+ *               TMAN_FAIL_TASK_NOT_ADDED if a task was not added
+ *               TMAN_FAIL_PRECEDENCE_CYCLE if the precedences form a cycle
+ *               TMAN_FAIL if TMAN_MAX_SUCCESSORS is exceeded or a join
+ *                         semaphore can't be created
+ *               TMAN_FAIL_NOT_FEASIBLE if every WCET is known and the
+ *               set fails the schedulability analysis
+ *               TMAN_FAIL_MODE_PENDING if a switch to this mode is pending
+ * Side Effects:	 
+ * Overview:     Record an operating mode: the PERIOD, PHASE, DEADLINE,
+ *               WCET and predecessor of each task while the mode is in
+ *               force. Tasks left out of the set are paused in it.
+ *               Everything a switch needs is resolved and checked
+ *               here, so TMAN_ModeSwitch() can't fail halfway.
+ *		
+ * Note:		 	BODY and PRIORITY of the entries are not used, the
+ *               tasks keep theirs. The analysis uses the current
+ *               priorities, or EDF in TMAN_MODE_EDF.
+ * 
+ ********************************************************************/
+
+int TMAN_ModeDefine(int mode, const tman_task_def set[], int count) {
+
+    static tman_analysis_task analysis[TMAN_MAX_TASKS];
+    static int successors[TMAN_MAX_TASKS];
+    const uint64_t tick_us = (uint64_t) tman_period * TMAN_US_PER_TICK;
+    int known = 1;
+
+    if (mode < 0 || mode >= TMAN_MAX_MODES || count < 1 || count > TMAN_MAX_TASKS)
+        return TMAN_FAIL_INVALID_ATTRIBUTE;
+    if (tman_mode_status.PENDING == mode)
+        return TMAN_FAIL_MODE_PENDING;
+
+    for (int k = 0; k < count; k++)
+        successors[k] = 0;
+
+    for (int k = 0; k < count; k++) {
+        const tman_task_def *def = &set[k];
+        if (def->PERIOD <= 0 || def->DEADLINE < 0 || def->DEADLINE > def->PERIOD
+                || def->PRECEDENCE >= count || def->PRECEDENCE == k)
+            return TMAN_FAIL_INVALID_ATTRIBUTE;
+
+        task_tman *task = prvTMAN_Find(def->NAME);
+        if (task == NULL)
+            return TMAN_FAIL_TASK_NOT_ADDED;
+        for (int j = 0; j < k; j++) {
+            if (analysis[j].ID == task - tman_task_list)
+                return TMAN_FAIL_INVALID_ATTRIBUTE;
+        }
+
+        // One predecessor each: a cycle is a chain longer than the set
+        int steps = 0;
+        for (int j = def->PRECEDENCE; j >= 0 && steps <= count; j = set[j].PRECEDENCE)
+            steps++;
+        if (steps > count)
+            return TMAN_FAIL_PRECEDENCE_CYCLE;
+        if (def->PRECEDENCE >= 0 && ++successors[def->PRECEDENCE] > TMAN_MAX_SUCCESSORS)
+            return TMAN_FAIL;
+
+        if (task->TASK_HANDLE == NULL)
+            prvTMAN_Bind(task, xTaskGetHandle(task->NAME));
+        known = known && def->WCET > 0 && (task->TASK_HANDLE != NULL || task->JOB_FN != NULL);
+
+        analysis[k].PERIOD = def->PERIOD * tick_us;
+        analysis[k].DEADLINE = (def->DEADLINE > 0 ? def->DEADLINE : def->PERIOD) * tick_us;
+        analysis[k].WCET = def->WCET;
+        analysis[k].BLOCKING = TMAN_TaskGetBlocking(task);
+        analysis[k].PRIORITY = prvTMAN_Priority(task);
+        analysis[k].ID = task - tman_task_list;
+    }
+
+    if (known) {
+        int misses = (tman_mode & TMAN_MODE_EDF) ? TMAN_AnalysisEDF(analysis, count)
+                                                 : TMAN_AnalysisRTA(analysis, count);
+        if (misses != 0)
+            return TMAN_FAIL_NOT_FEASIBLE;
+    }
+
+    // The switch itself allocates nothing
+    for (int k = 0; k < count; k++) {
+        task_tman *task = &tman_task_list[analysis[k].ID];
+        if (set[k].PRECEDENCE >= 0 && task->JOIN == NULL)
+            task->JOIN = xSemaphoreCreateCounting(TMAN_JOIN_MAX, 0);
+        if (set[k].PRECEDENCE >= 0 && task->JOIN == NULL)
+            return TMAN_FAIL;
+    }
+
+    tman_opmode *target = &tman_opmodes[mode];
+    taskENTER_CRITICAL();
+    for (int k = 0; k < count; k++) {
+        tman_mode_entry *entry = &target->TASKS[k];
+        entry->TASK = &tman_task_list[analysis[k].ID];
+        entry->PREDECESSOR = set[k].PRECEDENCE >= 0 ? &tman_task_list[analysis[set[k].PRECEDENCE].ID] : NULL;
+        entry->PERIOD = set[k].PERIOD;
+        entry->PHASE = set[k].PHASE;
+        entry->DEADLINE = set[k].DEADLINE > 0 ? set[k].DEADLINE : set[k].PERIOD;
+        entry->WCET = set[k].WCET;
+    }
+    target->COUNT = count;
+    taskEXIT_CRITICAL();
+
+    return TMAN_SUCCESS;
+}
+
+/********************************************************************
+ * Function: 	TMAN_ModeSwitch()
+ * Precondition: 
+ * Input: 		 mode, when (TMAN_SWITCH_IDLE or TMAN_SWITCH_HYPERPERIOD),
+ *               max_wait (TMAN ticks the safe point may take, 0 waits
+ *               for ever)
+ * Returns:      TMAN_SUCCESS if Ok, the switch is pending.
+ *               TMAN_FAIL_INVALID_ATTRIBUTE if the mode is not defined
+ *               or when/max_wait are invalid
+ *               TMAN_FAIL_MODE_PENDING if another switch is pending
+ *               TMAN_FAIL_TABLE_OVERFLOW if the current hyperperiod does
+ *               not fit 32 bits (TMAN_SWITCH_HYPERPERIOD)
+ * Side Effects:	 
+ * Overview:     Ask the dispatcher to put a mode defined with
+ *               TMAN_ModeDefine() in force. It switches at the first
+ *               instant where every released job has completed, or at
+ *               the first such hyperperiod boundary of the current
+ *               mode, all tasks at once: jobs of the old mode run to
+ *               completion under it, the new mode releases from the
+ *               switch instant on, so no job is dropped or released
+ *               twice. Phases of the new mode count from that instant.
+ *		
+ * Note:		 	Before the scheduler starts the mode is applied at once.
+ *               The latency (request to switch) is at most max_wait; a
+ *               request that finds no safe point by then is abandoned
+ *               and the old mode stays. Follow both in
+ *               TMAN_ModeGetStatus().
+ * 
+ ********************************************************************/
+
+int TMAN_ModeSwitch(int mode, int when, int max_wait) {
+
+    if (mode < 0 || mode >= TMAN_MAX_MODES || tman_opmodes[mode].COUNT == 0)
+        return TMAN_FAIL_INVALID_ATTRIBUTE;
+    if (when != TMAN_SWITCH_IDLE && when != TMAN_SWITCH_HYPERPERIOD)
+        return TMAN_FAIL_INVALID_ATTRIBUTE;
+    if (max_wait < 0)
+        return TMAN_FAIL_INVALID_ATTRIBUTE;
+
+    if (!tman_running) {
+        prvTMAN_ModeApply(&tman_opmodes[mode], 0);
+        tman_mode_status.CURRENT = mode;
+        tman_mode_status.SWITCHES++;
+        return TMAN_SUCCESS;
+    }
+
+    tman_time_t now = prvTMAN_Now();
+    tman_time_t at = now;
+
+    taskENTER_CRITICAL();
+    uint64_t hyperperiod = prvTMAN_Hyperperiod();
+    if (when == TMAN_SWITCH_HYPERPERIOD && hyperperiod != 0 && now > tman_mode_origin)
+        at = tman_mode_origin + (now - tman_mode_origin + hyperperiod - 1) / hyperperiod * hyperperiod;
+    int err = TMAN_SUCCESS;
+    if (tman_mode_status.PENDING >= 0)
+        err = TMAN_FAIL_MODE_PENDING;
+    else if (when == TMAN_SWITCH_HYPERPERIOD && hyperperiod == 0)
+        err = TMAN_FAIL_TABLE_OVERFLOW;
+    if (err == TMAN_SUCCESS) {
+        tman_switch_when = when;
+        tman_switch_requested = now;
+        tman_switch_at = at;
+        tman_switch_expires = max_wait > 0 ? now + max_wait : TMAN_TIME_NEVER;
+        tman_switch_hyperperiod = hyperperiod;
+        tman_mode_status.PENDING = mode;
+    }
+    taskEXIT_CRITICAL();
+
+    if (err == TMAN_SUCCESS)
+        xTaskNotifyGive(tman_handle);
+
+    return err;
+}
+
+/********************************************************************
+ * Function: 	TMAN_ModeGetStatus()
+ * Precondition: 
+ * Input: 		 caller-owned status struct
+ * Returns:      TMAN_SUCCESS
+ * Side Effects:	 
+ * Overview:     Mode in force, pending switch, and the latency and
+ *               dispatcher cost of the switches so far.
+ *		
+ * Note:		 	
+ * 
+ ********************************************************************/
+
+int TMAN_ModeGetStatus(tman_mode_status_t *out) {
+
+    taskENTER_CRITICAL();
+    *out = tman_mode_status;
+    taskEXIT_CRITICAL();
+
+    return TMAN_SUCCESS;
+}
+
+/********************************************************************
+ * Function: 	TMAN_TaskSetOverrunPolicy()
+ * Precondition: 
+ * Input: 		 task handle, policy (TMAN_OVERRUN_*), handler (only
+ *               for TMAN_OVERRUN_HANDLER)
+ * Returns:      TMAN_SUCCESS if Ok.
+ *               TMAN_FAIL_TASK_NOT_ADDED if the handle is not in use
+ *               TMAN_FAIL_INVALID_ATTRIBUTE if the policy is unknown or
+ *                                           the handler is missing
+ * Side Effects:	 
+ * Overview:     Choose what happens when a job of the task is still
+ *               pending at its deadline instant: keep running
+ *               (default), skip the next release, abort the job, or
+ *               call handler from the dispatcher.
+ *		
+ * Note:		 	Jobs can't be killed from outside: an aborted job ends
+ *               when its body polls TMAN_TaskAborted() and returns to
+ *               TMAN_TaskWaitPeriod(), and the next job restarts from
+ *               the top. Skipped releases are not passed on to the
+ *               dependents of the task.
+ * 
+ ********************************************************************/
+
+int TMAN_TaskSetOverrunPolicy(tman_handle_t task, int policy, tman_overrun_handler_t handler) {
+
+    if (task == NULL || !task->IN_USE)
+        return TMAN_FAIL_TASK_NOT_ADDED;
+    if (policy < TMAN_OVERRUN_CONTINUE || policy > TMAN_OVERRUN_HANDLER)
+        return TMAN_FAIL_INVALID_ATTRIBUTE;
+    if (policy == TMAN_OVERRUN_HANDLER && handler == NULL)
+        return TMAN_FAIL_INVALID_ATTRIBUTE;
+
+    taskENTER_CRITICAL();
+    task->OVERRUN_HANDLER = handler;
+    task->OVERRUN_POLICY = policy;
+    taskEXIT_CRITICAL();
+
+    return TMAN_SUCCESS;
+}
+
+/********************************************************************
+ * Function: 	TMAN_TaskSetBacklog()
+ * Precondition: 
+ * Input: 		 task handle, policy (TMAN_BACKLOG_*), depth (jobs
+ *               outstanding at most, for TMAN_BACKLOG_QUEUE)
+ * Returns:      TMAN_SUCCESS if Ok.
+ *               TMAN_FAIL_TASK_NOT_ADDED if the handle is not in use
+ *               TMAN_FAIL_INVALID_ATTRIBUTE if the policy is unknown or
+ *                                           the depth is not within
+ *                                           1..TMAN_BACKLOG_MAX
+ * Side Effects:	 
+ * Overview:     Choose what a release does while earlier jobs of the
+ *               task have not completed: queue and catch up later
+ *               (default, TMAN_BACKLOG_DEPTH jobs), coalesce into the
+ *               job waiting to start so only the newest release runs,
+ *               or drop it. Each outcome is counted in the stats.
+ *		
+ * Note:		 	Depth 1 drops every release that finds a job pending.
+ *               Dropped and coalesced releases are not passed on to the
+ *               dependents of the task.
+ * 
+ ********************************************************************/
+
+int TMAN_TaskSetBacklog(tman_handle_t task, int policy, int depth) {
+
+    if (task == NULL || !task->IN_USE)
+        return TMAN_FAIL_TASK_NOT_ADDED;
+    if (policy < TMAN_BACKLOG_QUEUE || policy > TMAN_BACKLOG_DROP || depth < 1 || depth > TMAN_BACKLOG_MAX)
+        return TMAN_FAIL_INVALID_ATTRIBUTE;
+
+    taskENTER_CRITICAL();
+    task->BACKLOG_POLICY = policy;
+    task->BACKLOG_DEPTH = depth;
+    taskEXIT_CRITICAL();
+
+    return TMAN_SUCCESS;
+}
+
+/********************************************************************
+ * Function: 	TMAN_TaskAborted()
+ * Precondition: Called from the task the handle belongs to
+ * Input: 		 task handle
+ * Returns:      1 if the running job missed its deadline under
+ *               TMAN_OVERRUN_ABORT and should return now, 0 otherwise
+ *               or if the handle is not in use
+ * Side Effects:	 
+ * Overview:     Cancellation point for long jobs.
+ *		
+ * Note:		 	A single load, cheap enough for inner loops.
+ * 
+ ********************************************************************/
+
+int TMAN_TaskAborted(tman_handle_t task) {
+    if (task == NULL || !task->IN_USE)
+        return 0;
+    return task->ABORT;
+}
+
+/********************************************************************
+ * Function: 	TMAN_TaskSetBudget()
+ * Precondition: Context switch hooks installed (FreeRTOSConfig.h)
+ * Input: 		 task handle, budget_us (CPU time per job, 0 for none),
+ *               policy (TMAN_BUDGET_DEMOTE or TMAN_BUDGET_SUSPEND)
+ * Returns:      TMAN_SUCCESS if Ok.
+ *               TMAN_FAIL_TASK_NOT_ADDED if the handle is not in use
+ *               TMAN_FAIL_INVALID_ATTRIBUTE if the policy is unknown or
+ *                                           the budget is negative
+ * Side Effects:	 
+ * Overview:     Bound the CPU time each job of the task may take,
+ *               preemptions excluded. A job that uses it up is demoted
+ *               to TMAN_BUDGET_PRIORITY or suspended, and counted in
+ *               BUDGET_OVERRUNS, until it completes or the next release
+ *               of the task gives it a new budget. Lower priority tasks
+ *               keep their share whatever the job does.
+ *		
+ * Note:		 	Enforced by the dispatcher on kernel ticks: a job may
+ *               run up to one tick past its budget. Set the budget at or
+ *               above the WCET the analysis used. A job inside a TMAN
+ *               resource is throttled when it unlocks. A suspended job
+ *               keeps the FreeRTOS mutexes it holds, prefer DEMOTE for
+ *               tasks that use them.
+ * 
+ ********************************************************************/
+
+int TMAN_TaskSetBudget(tman_handle_t task, int budget_us, int policy) {
+
+    if (task == NULL || !task->IN_USE)
+        return TMAN_FAIL_TASK_NOT_ADDED;
+    if (budget_us < 0 || (policy != TMAN_BUDGET_DEMOTE && policy != TMAN_BUDGET_SUSPEND)
+            || (task->JOB_FN != NULL && budget_us > 0))
+        return TMAN_FAIL_INVALID_ATTRIBUTE;
+
+    taskENTER_CRITICAL();
+    task->BUDGET = budget_us;
+    task->BUDGET_POLICY = policy;
+    if (budget_us == 0)
+        prvTMAN_BudgetRemove(task);
+    taskEXIT_CRITICAL();
+
+    return TMAN_SUCCESS;
+}
+
+/********************************************************************
+ * Function: 	TMAN_ResourceDeclare()
+ * Precondition: 
+ * Input: 		 task handle, resource name, longest critical section of
+ *               the task on it (microseconds)
+ * Returns:      Resource handle, NULL if the task is not added, the
+ *               length is negative or TMAN_MAX_RESOURCES /
+ *               TMAN_RESOURCE_USERS are exhausted
+ * Side Effects:	 Creates the resource on its first declaration.
+ * Overview:     Declare that the task locks the named resource, with
+ *               TMAN_ResourceLock(), for at most cs_us at a time. The
+ *               ceiling of the resource is the highest priority among
+ *               the tasks declared on it. Declaring again raises the
+ *               length if longer.
+ *		
+ * Note:		 	Declare every user before TMAN_CheckFeasibility(): the
+ *               blocking term of each task comes from these lengths.
+ *               Ceilings are recomputed when the dispatcher starts and
+ *               on mode switches; a task whose priority changes
+ *               otherwise must not hold or be about to lock a resource.
+ * 
+ ********************************************************************/
+
+tman_resource_t TMAN_ResourceDeclare(tman_handle_t task, char name[], int cs_us) {
+    tman_resource *resource = NULL;
+
+    if (task == NULL || !task->IN_USE || name == NULL || cs_us < 0)
+        return NULL;
+
+    for (int r = 0; r < TMAN_MAX_RESOURCES && resource == NULL; r++) {
+        if (tman_resources[r].IN_USE && strcmp(tman_resources[r].NAME, name) == 0)
+            resource = &tman_resources[r];
+    }
+    for (int r = 0; r < TMAN_MAX_RESOURCES && resource == NULL; r++) {
+        if (tman_resources[r].IN_USE)
+            continue;
+        SemaphoreHandle_t guard = xSemaphoreCreateMutex();
+        if (guard == NULL)
+            return NULL;
+        resource = &tman_resources[r];
+        memset(resource, 0, sizeof(*resource));
+        strncpy(resource->NAME, name, sizeof(resource->NAME) - 1);
+        resource->GUARD = guard;
+        resource->IN_USE = 1;
+    }
+    if (resource == NULL)
+        return NULL;
+
+    int k = 0;
+    while (k < resource->NUM_USERS && resource->USERS[k] != task)
+        k++;
+    if (k == resource->NUM_USERS) {
+        if (k == TMAN_RESOURCE_USERS)
+            return NULL;
+        resource->USERS[k] = task;
+        resource->CS_US[k] = 0;
+        resource->NUM_USERS++;
+    }
+    if ((uint32_t) cs_us > resource->CS_US[k])
+        resource->CS_US[k] = cs_us;
+
+    prvTMAN_ResourceCeilings();
+    return resource;
+}
+
+/********************************************************************
+ * Function: 	TMAN_ResourceLock()
+ * Precondition: Called by the task itself, TMAN_ResourceDeclare() for
+ *               this task and resource
+ * Input: 		 task handle, resource handle
+ * Returns:      TMAN_SUCCESS if Ok.
+ *               TMAN_FAIL_TASK_NOT_ADDED if the handle is not in use
+ *               TMAN_FAIL if the task is not a declared user, already
+ *               holds the resource or TMAN runs EDF
+ * Side Effects:	 The calling task runs at the ceiling until it unlocks.
+ * Overview:     Enter a critical section on the resource under the
+ *               immediate priority ceiling protocol: the task is raised
+ *               to the ceiling before it touches the resource, so no
+ *               other user can preempt it, and a job is blocked at most
+ *               once, for one critical section of a lower priority task,
+ *               before it starts. TMAN_TaskGetBlocking() gives that
+ *               bound.
+ *		
+ * Note:		 	Resources may nest; unlock in reverse order. The guard
+ *               mutex behind each resource is never contended while the
+ *               protocol holds; takes that found it held (tasks sharing
+ *               the ceiling priority with time slicing, priorities
+ *               changed behind TMAN) are counted in CONTENTIONS. Not
+ *               available under EDF, where priorities follow deadlines.
+ * 
+ ********************************************************************/
+
+int TMAN_ResourceLock(tman_handle_t task, tman_resource_t resource) {
+    int k = 0;
+
+    if (task == NULL || !task->IN_USE)
+        return TMAN_FAIL_TASK_NOT_ADDED;
+    if (resource == NULL || !resource->IN_USE || resource->OWNER == task
+            || (tman_mode & TMAN_MODE_EDF))
+        return TMAN_FAIL;
+    while (k < resource->NUM_USERS && resource->USERS[k] != task)
+        k++;
+    if (k == resource->NUM_USERS)
+        return TMAN_FAIL;
+
+    UBaseType_t priority = uxTaskPriorityGet(NULL);
+    if (resource->CEILING > priority)
+        vTaskPrioritySet(NULL, resource->CEILING);
+
+    if (xSemaphoreTake(resource->GUARD, 0) != pdTRUE) {
+        resource->CONTENTIONS++;
+        xSemaphoreTake(resource->GUARD, portMAX_DELAY);
+    }
+    resource->OWNER = task;
+    resource->SAVED_PRIORITY = priority;
+    task->LOCKS++;
+
+    return TMAN_SUCCESS;
+}
+
+/********************************************************************
+ * Function: 	TMAN_ResourceUnlock()
+ * Precondition: Called by the task that locked the resource
+ * Input: 		 task handle, resource handle
+ * Returns:      TMAN_SUCCESS if Ok.
+ *               TMAN_FAIL_TASK_NOT_ADDED if the handle is not in use
+ *               TMAN_FAIL if the task does not hold the resource
+ * Side Effects:	 The calling task may be preempted on return.
+ * Overview:     Leave the critical section and return to the priority
+ *               the task had when it locked.
+ *		
+ * Note:		 	
+ * 
+ ********************************************************************/
+
+int TMAN_ResourceUnlock(tman_handle_t task, tman_resource_t resource) {
+
+    if (task == NULL || !task->IN_USE)
+        return TMAN_FAIL_TASK_NOT_ADDED;
+    if (resource == NULL || resource->OWNER != task)
+        return TMAN_FAIL;
+
+    UBaseType_t priority = resource->SAVED_PRIORITY;
+    resource->OWNER = NULL;
+    task->LOCKS--;
+    xSemaphoreGive(resource->GUARD);
+    if (uxTaskPriorityGet(NULL) != priority)
+        vTaskPrioritySet(NULL, priority);
+
+    return TMAN_SUCCESS;
+}
+
+/********************************************************************
+ * Function: 	TMAN_TaskGetBlocking()
+ * Precondition: 
+ * Input: 		 task handle
+ * Returns:      Worst-case blocking of a job of the task (microseconds),
+ *               0 if the handle is not in use
+ * Side Effects:	 
+ * Overview:     Longest critical section, among the lower priority tasks,
+ *               on a resource whose ceiling reaches the task's priority.
+ *               Under the ceiling protocol a job waits for at most one
+ *               of them. TMAN_CheckFeasibility() adds it to the response
+ *               time of the task.
+ *		
+ * Note:		 	Uses the ceilings and priorities in place now.
+ * 
+ ********************************************************************/
+
+uint32_t TMAN_TaskGetBlocking(tman_handle_t task) {
+    uint32_t blocking = 0;
+
+    if (task == NULL || !task->IN_USE)
+        return 0;
+
+    UBaseType_t priority = prvTMAN_BasePriority(task);
+    for (int r = 0; r < TMAN_MAX_RESOURCES; r++) {
+        tman_resource *resource = &tman_resources[r];
+        if (!resource->IN_USE || resource->CEILING < priority)
+            continue;
+        for (int k = 0; k < resource->NUM_USERS; k++) {
+            if (resource->USERS[k] != task
+                    && prvTMAN_BasePriority(resource->USERS[k]) < priority
+                    && resource->CS_US[k] > blocking)
+                blocking = resource->CS_US[k];
+        }
+    }
+    return blocking;
+}
+
+/********************************************************************
+ * Function: 	TMAN_TaskSetSporadic()
+ * Precondition: 
+ * Input: 		 task handle, minimum inter-arrival time (TMAN ticks)
+ * Returns:      TMAN_SUCCESS if Ok.
+ *               TMAN_FAIL_TASK_NOT_ADDED if the handle is not in use
+ *               TMAN_FAIL_INVALID_ATTRIBUTE if the time is below 1
+ * Side Effects:	 The task is no longer released periodically.
+ * Overview:     Release the task on TMAN_TaskTrigger() and
+ *               TMAN_TaskTriggerFromISR() instead of its PERIOD/PHASE.
+ *               Two releases are at least min_interarrival apart: an
+ *               earlier trigger is held back until then, and further
+ *               triggers meanwhile are merged into it. Also the MIT
+ *               attribute.
+ *		
+ * Note:		 	PERIOD becomes the minimum inter-arrival time (and
+ *               DEADLINE, if none was set), so TMAN_CheckFeasibility()
+ *               and the priority assignment treat the task as periodic,
+ *               its worst case.
+ * 
+ ********************************************************************/
+
+int TMAN_TaskSetSporadic(tman_handle_t task, int min_interarrival) {
+
+    if (task == NULL || !task->IN_USE)
+        return TMAN_FAIL_TASK_NOT_ADDED;
+    if (min_interarrival < 1)
+        return TMAN_FAIL_INVALID_ATTRIBUTE;
+
+    taskENTER_CRITICAL();
+    task->PERIOD = min_interarrival;
+    if (!(task->DEADLINE > 0))
+        task->DEADLINE = min_interarrival;
+    if (!task->SPORADIC) {
+        task->SPORADIC = 1;
+        prvTMAN_HeapRemove(task);
+    }
+    taskEXIT_CRITICAL();
+
+    if (tman_running && (tman_mode & TMAN_MODE_TIME_TRIGGERED))
+        tman_tt_dirty = 1;
+
+    return TMAN_SUCCESS;
+}
+
+/* Flag a trigger for the dispatcher. Called inside a critical section. */
+static int prvTMAN_Trigger(task_tman *task) {
+    const int slot = task - tman_task_list;
+    const uint32_t bit = 1UL << (slot % 32);
+
+    if (tman_trigger_mask[slot / 32] & bit) {
+        task->MERGED_TRIGGERS++;
+        return 0;
+    }
+    task->TRIGGER_STAMP = TMAN_TIMESTAMP();
+    tman_trigger_mask[slot / 32] |= bit;
+    return 1;
+}
+
+/********************************************************************
+ * Function: 	TMAN_TaskTrigger()
+ * Precondition: TMAN_TaskSetSporadic() done for the task
+ * Input: 		 task handle
+ * Returns:      TMAN_SUCCESS if Ok.
+ *               TMAN_FAIL_TASK_NOT_ADDED if the handle is not in use
+ *               TMAN_FAIL_INVALID_ATTRIBUTE if the task is not sporadic
+ * Side Effects:	 
+ * Overview:     Ask for one release of a sporadic task. The dispatcher
+ *               releases it at once, or at the end of its minimum
+ *               inter-arrival time.
+ *		
+ * Note:		 	O(1). The response time counts from the trigger.
+ * 
+ ********************************************************************/
+
+int TMAN_TaskTrigger(tman_handle_t task) {
+
+    if (task == NULL || !task->IN_USE)
+        return TMAN_FAIL_TASK_NOT_ADDED;
+    if (!task->SPORADIC)
+        return TMAN_FAIL_INVALID_ATTRIBUTE;
+
+    taskENTER_CRITICAL();
+    int wake = prvTMAN_Trigger(task);
+    taskEXIT_CRITICAL();
+
+    if (wake && tman_running)
+        xTaskNotifyGive(tman_handle);
+
+    return TMAN_SUCCESS;
+}
+
+/********************************************************************
+ * Function: 	TMAN_TaskTriggerFromISR()
+ * Precondition: TMAN_TaskSetSporadic() done for the task, interrupt
+ *               priority at or below configMAX_SYSCALL_INTERRUPT_PRIORITY
+ * Input: 		 task handle, pxHigherPriorityTaskWoken (as for the
+ *               FreeRTOS FromISR calls)
+ * Returns:      Same as TMAN_TaskTrigger()
+ * Side Effects:	 
+ * Overview:     TMAN_TaskTrigger() for interrupt handlers. Call
+ *               portYIELD_FROM_ISR() with *pxHigherPriorityTaskWoken
+ *               on the way out, the dispatcher then runs right after
+ *               the interrupt.
+ *		
+ * Note:		 	Sets a bit and notifies the dispatcher, nothing else.
+ * 
+ ********************************************************************/
+
+int TMAN_TaskTriggerFromISR(tman_handle_t task, BaseType_t *pxHigherPriorityTaskWoken) {
+
+    if (task == NULL || !task->IN_USE)
+        return TMAN_FAIL_TASK_NOT_ADDED;
+    if (!task->SPORADIC)
+        return TMAN_FAIL_INVALID_ATTRIBUTE;
+
+    UBaseType_t saved = taskENTER_CRITICAL_FROM_ISR();
+    int wake = prvTMAN_Trigger(task);
+    taskEXIT_CRITICAL_FROM_ISR(saved);
+
+    if (wake && tman_running)
+        vTaskNotifyGiveFromISR(tman_handle, pxHigherPriorityTaskWoken);
+
+    return TMAN_SUCCESS;
+}
+
+/* Queued aperiodic job */
+typedef struct tman_aperiodic {
+    tman_job_fn_t FN;
+    void *ARG;
+    uint32_t STAMP;             // core timer count at submission
+} tman_aperiodic;
+
+/* Execution time of the running job so far, preemptions excluded */
+static uint32_t prvTMAN_JobExec(task_tman *task) {
+    taskENTER_CRITICAL();
+    uint32_t exec = task->JOB_EXEC + (TMAN_TIMESTAMP() - task->RUN_START);
+    taskEXIT_CRITICAL();
+    return exec;
+}
+
+/* Kernel ticks a deferrable server may still wait for jobs: up to one
+ * tick before its deadline, so the instance completes in time. 0 once a
+ * later release is already queued. */
+static TickType_t prvTMAN_ServerWindow(task_tman *server) {
+    taskENTER_CRITICAL();
+    uint64_t end = (server->LAST_ACTIVATION + server->DEADLINE) * tman_period;
+    int queued = server->OUTSTANDING > 1;
+    taskEXIT_CRITICAL();
+
+    uint64_t kernel = prvTMAN_KernelTime();
+    if (queued || end <= kernel + 1)
+        return 0;
+    return end - kernel - 1 < portMAX_DELAY / 2 ? end - kernel - 1 : portMAX_DELAY / 2;
+}
+
+/* Server body: one TMAN job per period, which runs queued aperiodic jobs
+ * while its budget (WCET) lasts. A job started with budget left runs to
+ * its end, the overrun is taken from the next periods. */
+static void prvTMAN_Server(void *pvParam) {
+    task_tman *server = (task_tman *) pvParam;
+    uint32_t debt = 0;
+    tman_aperiodic job;
+
+    for (;;) {
+        TMAN_TaskWaitPeriodEx(server);
+
+        const uint32_t budget = server->WCET * TMAN_COUNTS_PER_US;
+        uint32_t allowed = budget > debt ? budget - debt : 0;
+        uint32_t used = 0;
+        debt = debt > budget ? debt - budget : 0;
+
+        while (used < allowed) {
+            TickType_t wait = server->SERVER_POLICY == TMAN_SERVER_DEFERRABLE ? prvTMAN_ServerWindow(server) : 0;
+            if (xQueueReceive(server->SERVER_QUEUE, &job, wait) != pdPASS)
+                break;
+
+            job.FN(job.ARG);
+            uint32_t response = TMAN_TIMESTAMP() - job.STAMP;
+            used = prvTMAN_JobExec(server);
+
+            prvTMAN_SeqBegin(&server->JOB_SEQ);
+            server->APERIODIC_JOBS++;
+            if (response > server->APERIODIC_RESPONSE_MAX)
+                server->APERIODIC_RESPONSE_MAX = response;
+            server->APERIODIC_RESPONSE_SUM += response;
+            prvTMAN_SeqEnd(&server->JOB_SEQ);
+        }
+
+        if (used > allowed)
+            debt += used - allowed;
+    }
+}
+
+/********************************************************************
+ * Function: 	TMAN_ServerCreate()
+ * Precondition: 
+ * Input: 		 name, period (TMAN ticks), budget_us (execution time per
+ *               period, in microseconds), priority, policy
+ *               (TMAN_SERVER_POLLING or TMAN_SERVER_DEFERRABLE)
+ * Returns:      Handle of the server if Ok.
+ *               NULL if an argument is invalid, the task list is full or
+ *               the FreeRTOS task or queue can't be created
+ * Side Effects:	 Creates a FreeRTOS task (TMAN_SERVER_STACK) and a queue
+ *               of TMAN_SERVER_QUEUE jobs.
+ * Overview:     Aperiodic server: a periodic TMAN task that runs the
+ *               jobs given to TMAN_ServerSubmit() for at most budget_us
+ *               of CPU per period. The polling server only serves the
+ *               jobs queued at its release, the deferrable server also
+ *               those that arrive later in the period, for shorter
+ *               response times.
+ *		
+ * Note:		 	Analysed as a periodic task with WCET budget_us and the
+ *               deadline of its period, so the periodic tasks keep
+ *               their guarantees. The deferrable server can run its
+ *               budget back to back across a period boundary; leave
+ *               room for it or use the polling server. Aperiodic jobs
+ *               run on the server stack and must not block.
+ * 
+ ********************************************************************/
+
+tman_handle_t TMAN_ServerCreate(char name[], int period, int budget_us, UBaseType_t priority, int policy) {
+
+    if (period < 1 || budget_us < 1 || (policy != TMAN_SERVER_POLLING && policy != TMAN_SERVER_DEFERRABLE))
+        return NULL;
+
+    QueueHandle_t queue = xQueueCreate(TMAN_SERVER_QUEUE, sizeof(tman_aperiodic));
+    if (queue == NULL)
+        return NULL;
+
+    task_tman *server = TMAN_TaskAdd(name);
+    if (server == NULL) {
+        vQueueDelete(queue);
+        return NULL;
+    }
+
+    server->SERVER_QUEUE = queue;
+    server->SERVER_POLICY = policy;
+    server->WCET = budget_us;
+
+    TaskHandle_t handle;
+    if (xTaskCreate(prvTMAN_Server, (const signed char * const) server->NAME, TMAN_SERVER_STACK,
+                    (void *) server, priority, &handle) != pdPASS) {
+        server->SERVER_QUEUE = NULL;
+        TMAN_TaskRemove(server);
+        vQueueDelete(queue);
+        return NULL;
+    }
+    prvTMAN_Bind(server, handle);
+
+    taskENTER_CRITICAL();
+    server->PERIOD = period;
+    server->DEADLINE = period;
+    if (tman_running)
+        prvTMAN_Schedule(server, prvTMAN_Now());
+    taskEXIT_CRITICAL();
+
+    if (tman_running)
+        xTaskNotifyGive(tman_handle);
+
+    return server;
+}
+
+/********************************************************************
+ * Function: 	TMAN_ServerSubmit()
+ * Precondition: 
+ * Input: 		 server handle, job function, its argument
+ * Returns:      TMAN_SUCCESS if Ok.
+ *               TMAN_FAIL_TASK_NOT_ADDED if the handle is not in use
+ *               TMAN_FAIL_INVALID_ATTRIBUTE if it is not a server or fn
+ *                                           is NULL
+ *               TMAN_FAIL if the server queue is full (counted)
+ * Side Effects:	 
+ * Overview:     Queue fn(arg) for the server. Jobs run in submission
+ *               order, each to completion.
+ *		
+ * Note:		 	Never blocks.
+ * 
+ ********************************************************************/
+
+int TMAN_ServerSubmit(tman_handle_t server, tman_job_fn_t fn, void *arg) {
+
+    if (server == NULL || !server->IN_USE)
+        return TMAN_FAIL_TASK_NOT_ADDED;
+    if (server->SERVER_QUEUE == NULL || fn == NULL)
+        return TMAN_FAIL_INVALID_ATTRIBUTE;
+
+    tman_aperiodic job = { fn, arg, TMAN_TIMESTAMP() };
+    if (xQueueSend(server->SERVER_QUEUE, &job, 0) != pdPASS) {
+        taskENTER_CRITICAL();
+        server->APERIODIC_DROPPED++;
+        taskEXIT_CRITICAL();
+        return TMAN_FAIL;
+    }
+
+    return TMAN_SUCCESS;
+}
+
+/********************************************************************
+ * Function: 	TMAN_ServerSubmitFromISR()
+ * Precondition: Interrupt priority at or below
+ *               configMAX_SYSCALL_INTERRUPT_PRIORITY
+ * Input: 		 server handle, job function, its argument,
+ *               pxHigherPriorityTaskWoken
+ * Returns:      Same as TMAN_ServerSubmit()
+ * Side Effects:	 
+ * Overview:     TMAN_ServerSubmit() for interrupt handlers.
+ *		
+ * Note:		 	
+ * 
+ ********************************************************************/
+
+int TMAN_ServerSubmitFromISR(tman_handle_t server, tman_job_fn_t fn, void *arg,
+                             BaseType_t *pxHigherPriorityTaskWoken) {
+
+    if (server == NULL || !server->IN_USE)
+        return TMAN_FAIL_TASK_NOT_ADDED;
+    if (server->SERVER_QUEUE == NULL || fn == NULL)
+        return TMAN_FAIL_INVALID_ATTRIBUTE;
+
+    tman_aperiodic job = { fn, arg, TMAN_TIMESTAMP() };
+    if (xQueueSendFromISR(server->SERVER_QUEUE, &job, pxHigherPriorityTaskWoken) != pdPASS) {
+        UBaseType_t saved = taskENTER_CRITICAL_FROM_ISR();
+        server->APERIODIC_DROPPED++;
+        taskEXIT_CRITICAL_FROM_ISR(saved);
+        return TMAN_FAIL;
+    }
+
+    return TMAN_SUCCESS;
+}
+
+/********************************************************************
+ * Function: 	TMAN_TaskWaitPeriod()
+ * Precondition: 
+ * Input: 		 
+ * Returns:      
+ * Side Effects:	 
+ * Overview:     Called by a task to signal the termination of an 
+ *               instance and wait for the next activation.
+ * 
+ *		
+ * Note:		 	Compatibility wrapper for TMAN_TaskWaitPeriodEx()
+ * 
+ ********************************************************************/
+
+int TMAN_TaskWaitPeriod(char * pvParameters){
+    return TMAN_TaskWaitPeriodEx(prvTMAN_Find(pvParameters));
+}
+
+/* Bookkeeping of a job that just ended: execution and response times,
+ * deadline watch, budget, dependents. From the task itself, or from the
+ * executor of a run-to-completion job. */
+static void prvTMAN_JobEnd(task_tman *task) {
+
+    // Execution time of the job that just ended, preemptions excluded
+    taskENTER_CRITICAL();
+    uint32_t now = TMAN_TIMESTAMP();
+    uint32_t exec = task->JOB_EXEC + (now - task->RUN_START);
+    // Measured from the release of this job, not the newest one
+    uint32_t response = now - task->JOB_STAMP[task->JOB_HEAD];
+    task->JOB_ACTIVE = 0;
+    if (task->OUTSTANDING > 0) {
+        task->OUTSTANDING--;
+        task->JOB_HEAD = (task->JOB_HEAD + 1) % TMAN_BACKLOG_MAX;
+    }
+    taskEXIT_CRITICAL();
+
+    int aborted = task->ABORT;
+    TMAN_TRACE_EVENT(TMAN_TRACE_COMPLETE, task, 0);
+
+    // Stop watching this job, and watch the oldest job released while it
+    // ran, at its own deadline (misses were counted by the dispatcher)
+    int rearm = 0;
+    taskENTER_CRITICAL();
+    prvTMAN_WatchRemove(task);
+    if (task->DEADLINE > 0 && task->OUTSTANDING > 0) {
+        prvTMAN_WatchInsert(task, task->JOB_RELEASE[task->JOB_HEAD] + task->DEADLINE);
+        rearm = 1;
+    }
+    task->LATE = 0;
+    task->ABORT = 0;
+    if (task->OUTSTANDING == 0)
+        prvTMAN_BudgetRemove(task);
+    taskEXIT_CRITICAL();
+    if (task->THROTTLED)
+        prvTMAN_Unthrottle(task, 0);
+    // A pending mode change waits for the last outstanding job
+    if ((rearm || (tman_mode_status.PENDING >= 0 && task->OUTSTANDING == 0)) && tman_running)
+        xTaskNotifyGive(tman_handle);
+
+    prvTMAN_SeqBegin(&task->JOB_SEQ);
+    if (task->EXEC_COUNT == 0 || exec < task->EXEC_MIN)
+        task->EXEC_MIN = exec;
+    if (exec > task->EXEC_MAX)
+        task->EXEC_MAX = exec;
+    task->EXEC_SUM += exec;
+    if (task->EXEC_COUNT == 0 || response < task->RESPONSE_MIN)
+        task->RESPONSE_MIN = response;
+    if (response > task->RESPONSE_MAX)
+        task->RESPONSE_MAX = response;
+    task->RESPONSE_SUM += response;
+#if TMAN_RESPONSE_HISTOGRAM
+    TMAN_HistogramAdd(&task->RESPONSE_HIST, response / TMAN_COUNTS_PER_US);
+#endif
+    task->EXEC_COUNT++;
+    if (aborted)
+        task->ABORTED_JOBS++;
+    prvTMAN_SeqEnd(&task->JOB_SEQ);
+
+    // Job done, let the dependents know
+    if (task->NUM_SUCCESSORS > 0)
+        prvTMAN_Complete(task);
+
+    // Leave the deadline queue, or requeue with the deadline of the
+    // oldest job released while this one was still running
+    if (task->EDF_INDEX >= 0) {
+        taskENTER_CRITICAL();
+        prvTMAN_EdfRemove(task);
+        if (task->OUTSTANDING > 0)
+            prvTMAN_EdfInsert(task, task->JOB_RELEASE[task->JOB_HEAD] + task->DEADLINE);
+        prvTMAN_EdfDispatch();
+        taskEXIT_CRITICAL();
+    }
+}
+
+/* Bookkeeping of a job that starts now, latency: release to wake up */
+static void prvTMAN_JobBegin(task_tman *task, uint32_t latency) {
 
-static int tman_period;
-static int last_index = 0;
+    taskENTER_CRITICAL();
+    uint32_t start = TMAN_TIMESTAMP();
+    task->JOB_EXEC = 0;
+    task->RUN_START = start;
+    task->JOB_ACTIVE = 1;
+    // The job starting is the oldest outstanding one
+    uint32_t start_latency = start - task->JOB_STAMP[task->JOB_HEAD];
+    taskEXIT_CRITICAL();
+    TMAN_TRACE_EVENT(TMAN_TRACE_START, task, 0);
 
-void pvTMAN_Task(void *pvParam) {
-    TickType_t xLastWakeTime = xTaskGetTickCount();
-    vTaskDelay(1);
-    const TickType_t xFrequency = tman_period;
+
+    prvTMAN_SeqBegin(&task->JOB_SEQ);
+    task->NUM_ACTIVATIONS++;
+    if (latency > task->LATENCY_MAX)
+        task->LATENCY_MAX = latency;
+    if (start_latency > task->START_LATENCY_MAX)
+        task->START_LATENCY_MAX = start_latency;
+    task->START_LATENCY_SUM += start_latency;
+    prvTMAN_SeqEnd(&task->JOB_SEQ);
+}
+
+/********************************************************************
+ * Function: 	TMAN_TaskWaitPeriodEx()
+ * Precondition: Called from the task the handle belongs to
+ * Input: 		 task handle
+ * Returns:      TMAN_SUCCESS if Ok.
+ *               TMAN_FAIL_TASK_NOT_ADDED if the handle is NULL
+ *               TMAN_FAIL if it is a job (TMAN_JobAdd())
+ * Side Effects:	 
+ * Overview:     Called by a task to signal the termination of an 
+ *               instance and wait for the next activation.
+ *		
+ * Note:		 	O(1): no name lookups, the kernel handle is cached on
+ *               the first call. Activations are counted in the task
+ *               notification value, which TMAN owns for managed tasks.
+ * 
+ ********************************************************************/
+
+int TMAN_TaskWaitPeriodEx(tman_handle_t task){
+
+    if (task == NULL)
+        return TMAN_FAIL_TASK_NOT_ADDED;
+    if (task->JOB_FN != NULL)
+        return TMAN_FAIL;
+
+    if (task->TASK_HANDLE == NULL)
+        prvTMAN_Bind(task, xTaskGetCurrentTaskHandle());
+
+    if (task->NUM_ACTIVATIONS > 0)
+        prvTMAN_JobEnd(task);
+
+#if TMAN_ACTIVATION_SUSPEND
+    // A queued release already resumed this task while it ran
+    if (task->OUTSTANDING == 0)
+        vTaskSuspend(NULL);
+#else
+    ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+#endif
+
+    uint32_t latency = TMAN_TIMESTAMP() - task->JOB_STAMP[task->JOB_HEAD];
+
+    // If it has precedence, wait until all predecessors completed a job
+    if (task->NUM_PREDECESSORS > 0) {
+        TMAN_TRACE_EVENT(TMAN_TRACE_PRECEDENCE_WAIT, task, 0);
+        xSemaphoreTake(task->JOIN, portMAX_DELAY);
+    }
+
+    // Job starts now
+    prvTMAN_JobBegin(task, latency);
+
+    return TMAN_SUCCESS;
+}
+
+/* Run the ready jobs of one band, lowest slot first, each to completion.
+ * The kernel tag follows the running job, so the context switch hooks
+ * charge preemptions by higher bands to the right job. */
+static void prvTMAN_Executor(void *pvParam) {
+    tman_executor *executor = (tman_executor *) pvParam;
 
     for (;;) {
-       
-        for (int i = 0; i < ARRAY_SIZE; i++) {
-            int act = 0;
-            if (!tman_task_list[i].PERIOD == 0)
-                act = (xLastWakeTime % (tman_task_list[i].PERIOD * tman_period)) - (tman_task_list[i].PHASE * tman_period);
-            if (act == 0) {
-
-                TaskHandle_t task_handle = xTaskGetHandle(tman_task_list[i].NAME);
-                vTaskResume(task_handle);
-            }            
-        }
-        
-        // Wait for the next cycle.
-        vTaskDelayUntil(&xLastWakeTime, xFrequency);
-        
-        // Uncomment to test TMAN_TaskStats()
-        if (tman_ticks > 20) {
-            PrintStr("Testing TMAN_TaskStats(\"B\") - tman.c line 61\n\r");
-            
-            int* stats = TMAN_TaskStats("B");
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
 
-            uint8_t message[80];
-            sprintf(message, "Task %s - N. Activations: %d - Deadline Misses: %d\n\r", "B", stats[0], stats[1]);
-            PrintStr(message);
-            TMAN_Close();
+        for (int w = 0; w < TMAN_TT_MASK_WORDS; w++) {
+            while (executor->READY[w] != 0) {
+                taskENTER_CRITICAL();
+                uint32_t bit = executor->READY[w] & -executor->READY[w];
+                executor->READY[w] &= ~bit;
+                taskEXIT_CRITICAL();
+
+                task_tman *task = &tman_task_list[w * 32 + __builtin_ctz(bit)];
+                if (!task->IN_USE || task->JOB_FN == NULL || task->OUTSTANDING == 0)
+                    continue;
+                uint32_t latency = TMAN_TIMESTAMP() - task->JOB_STAMP[task->JOB_HEAD];
+                // Readied again by the predecessor that completes the join
+                if (task->NUM_PREDECESSORS > 0 && xSemaphoreTake(task->JOIN, 0) != pdTRUE)
+                    continue;
+
+#if configUSE_APPLICATION_TASK_TAG == 1
+                vTaskSetApplicationTaskTag(NULL, (TaskHookFunction_t) task);
+#endif
+                prvTMAN_JobBegin(task, latency);
+                task->JOB_FN(task->JOB_ARG);
+                prvTMAN_JobEnd(task);
+#if configUSE_APPLICATION_TASK_TAG == 1
+                vTaskSetApplicationTaskTag(NULL, NULL);
+#endif
+                // One bit stands for all the releases of the job: keep it
+                // set while queued releases are left
+                taskENTER_CRITICAL();
+                if (task->OUTSTANDING > 0 && task->IN_USE)
+                    executor->READY[w] |= bit;
+                taskEXIT_CRITICAL();
+                // Lower slots may have become ready meanwhile: scan again
+                // from the first word
+                w = -1;
+                break;
+            }
         }
-        
-        tman_ticks++;
     }
 }
 
+/* Create the executor of a band, once */
+static int prvTMAN_ExecutorCreate(int band) {
+    static char names[TMAN_EXECUTOR_BANDS][8];
+    tman_executor *executor = &tman_executors[band];
+
+    if (executor->HANDLE != NULL)
+        return TMAN_SUCCESS;
+    sprintf(names[band], "TMANX%d", band);
+    if (xTaskCreate(prvTMAN_Executor, names[band], TMAN_EXECUTOR_STACK, executor,
+                    TMAN_EXECUTOR_PRIORITY + band, &executor->HANDLE) != pdPASS)
+        return TMAN_FAIL;
+    return TMAN_SUCCESS;
+}
+
 /********************************************************************
- * Function: 	TMAN_Init()
+ * Function: 	TMAN_JobAdd()
  * Precondition: 
- * Input: 		 tick_ms
+ * Input: 		 job name, function, argument passed to it
+ * Returns:      Job handle (see TMAN_TaskAdd()), NULL if the task list
+ *               is full, the name is taken or the executor could not be
+ *               created
+ * Side Effects:	 Creates the executor of band 0 with the first job.
+ * Overview:     Add a run-to-completion job: released like a task (same
+ *               attributes, precedence, stats), but each release calls
+ *               fn(arg) from the executor task of its band instead of
+ *               waking a task of its own. No stack, TCB or context
+ *               switch per job: a release sets the job's bit in the
+ *               band's ready bitmap, and the executor runs the ready
+ *               jobs back to back. Band 0 unless TMAN_JobSetBand().
+ *		
+ * Note:		 	fn must return, not block and not call
+ *               TMAN_TaskWaitPeriodEx(): it holds up every job of its
+ *               band. Within a band the lowest slot runs first and jobs
+ *               do not preempt each other. Jobs keep the priority of
+ *               their band under TMAN_AssignPriorities() and EDF, and
+ *               take no CPU budget. Precedence with tasks works both
+ *               ways.
+ * 
+ ********************************************************************/
+
+tman_handle_t TMAN_JobAdd(char name[], tman_job_fn_t fn, void *arg) {
+
+    if (fn == NULL || prvTMAN_ExecutorCreate(0) != TMAN_SUCCESS)
+        return NULL;
+    return prvTMAN_Add(name, fn, arg);
+}
+
+/********************************************************************
+ * Function: 	TMAN_JobSetBand()
+ * Precondition: No release of the job pending
+ * Input: 		 job handle, band (0 .. TMAN_EXECUTOR_BANDS - 1)
  * Returns:      TMAN_SUCCESS if Ok.
- * Side Effects:	 
- * Overview:     Initializes Task Manager Framework.
+ *               TMAN_FAIL_TASK_NOT_ADDED if the handle is not in use
+ *               TMAN_FAIL_INVALID_ATTRIBUTE if it is not a job or the
+ *                                           band is out of range
+ *               TMAN_FAIL if the executor could not be created
+ * Side Effects:	 Creates the executor of the band.
+ * Overview:     Run the job at priority TMAN_EXECUTOR_PRIORITY + band.
+ *               Jobs of a higher band preempt those of a lower one.
+ *               Also the BAND attribute.
  *		
  * Note:		 	
  * 
  ********************************************************************/
 
-int TMAN_Init(int tick_ms) {
-    
-    
-    
-    tman_period = tick_ms;
-    xTaskCreate(pvTMAN_Task, (const signed char * const) "TMAN", 
-                configMINIMAL_STACK_SIZE, NULL, PRIORITY, NULL);
-    
+int TMAN_JobSetBand(tman_handle_t job, int band) {
+
+    if (job == NULL || !job->IN_USE)
+        return TMAN_FAIL_TASK_NOT_ADDED;
+    if (job->JOB_FN == NULL || band < 0 || band >= TMAN_EXECUTOR_BANDS)
+        return TMAN_FAIL_INVALID_ATTRIBUTE;
+    if (prvTMAN_ExecutorCreate(band) != TMAN_SUCCESS)
+        return TMAN_FAIL;
+
+    job->BAND = band;
+    prvTMAN_ResourceCeilings();
     return TMAN_SUCCESS;
-    
 }
 
 /********************************************************************
- * Function: 	TMAN_Close()
+ * Function: 	TMAN_TaskStats()
  * Precondition: 
- * Input: 		
- * Returns:      TMAN_SUCCESS if Ok.
+ * Input: 		char taskName[]
+ * Returns:      returns statistical information about a task:
+ *               {activations, deadline misses}, NULL if the task
+ *               was not added.
  * Side Effects:	 
- * Overview:     Terminates Task Manager Framework.
+ * Overview:     returns statistical information about a task.
  *		
- * Note:		 	Ends the scheduler
+ * Note:		 	Not reentrant, the array is shared by all callers.
+ *               Use TMAN_TaskStatsEx() instead.
  * 
  ********************************************************************/
 
-int TMAN_Close(){
+int * TMAN_TaskStats(char taskName[]){
+    
+    static int ret[2];
+    
+    task_tman *task = prvTMAN_Find(taskName);
+    if (task == NULL)
+        return NULL;
 
-    vTaskEndScheduler();
+    tman_stats_t stats;
+    if (TMAN_TaskStatsEx(task, &stats) != TMAN_SUCCESS)
+        return NULL;
+
+    ret[0] = stats.ACTIVATIONS;
+    ret[1] = stats.DEADLINE_MISSES;
     
-    return TMAN_SUCCESS;
+    return ret;
+}
+
+static uint32_t prvTMAN_CountsToUs(uint64_t counts) {
+    return counts * 1000000 / TMAN_TIMESTAMP_HZ;
+}
+
+/* May see a torn update, prvTMAN_StatsFill() then discards the copy.
+ * Divisors are read once so they cannot turn 0 mid-copy. */
+static void prvTMAN_StatsCopy(task_tman *task, tman_stats_t *out) {
+    uint32_t jobs = task->EXEC_COUNT;
+    uint32_t activations = task->NUM_ACTIVATIONS;
+    uint32_t served = task->APERIODIC_JOBS;
+
+    out->ACTIVATIONS = activations;
+    out->DEADLINE_MISSES = task->DEADLINE_MISSES;
+    out->COMPLETED_JOBS = jobs;
+    out->RESPONSE_MIN = prvTMAN_CountsToUs(task->RESPONSE_MIN);
+    out->RESPONSE_MAX = prvTMAN_CountsToUs(task->RESPONSE_MAX);
+    out->RESPONSE_AVG = jobs ? prvTMAN_CountsToUs(task->RESPONSE_SUM / jobs) : 0;
+    out->EXEC_MIN = prvTMAN_CountsToUs(task->EXEC_MIN);
+    out->EXEC_MAX = prvTMAN_CountsToUs(task->EXEC_MAX);
+    out->EXEC_AVG = jobs ? prvTMAN_CountsToUs(task->EXEC_SUM / jobs) : 0;
+    out->RELEASE_JITTER = prvTMAN_CountsToUs(task->JITTER_MAX);
+    out->START_LATENCY_MAX = prvTMAN_CountsToUs(task->START_LATENCY_MAX);
+    out->START_LATENCY_AVG = activations ? prvTMAN_CountsToUs(task->START_LATENCY_SUM / activations) : 0;
+    out->PREEMPTIONS = task->PREEMPTIONS;
+    out->SKIPPED_RELEASES = task->SKIPPED_RELEASES;
+    out->ABORTED_JOBS = task->ABORTED_JOBS;
+    out->QUEUED_RELEASES = task->QUEUED_RELEASES;
+    out->COALESCED_RELEASES = task->COALESCED_RELEASES;
+    out->DROPPED_RELEASES = task->DROPPED_RELEASES;
+    out->BUDGET_OVERRUNS = task->BUDGET_OVERRUNS;
+    out->DEFERRED_RELEASES = task->DEFERRED_RELEASES;
+    out->MERGED_TRIGGERS = task->MERGED_TRIGGERS;
+    out->APERIODIC_JOBS = served;
+    out->APERIODIC_RESPONSE_MAX = prvTMAN_CountsToUs(task->APERIODIC_RESPONSE_MAX);
+    out->APERIODIC_RESPONSE_AVG = served ? prvTMAN_CountsToUs(task->APERIODIC_RESPONSE_SUM / served) : 0;
+    out->APERIODIC_DROPPED = task->APERIODIC_DROPPED;
+}
+
+/* Copy the stats of a task without locks, returns 0 if both blocks
+ * could not be read between updates in TMAN_STATS_RETRIES attempts */
+static int prvTMAN_StatsFill(task_tman *task, tman_stats_t *out) {
+
+    for (int attempt = 0; attempt < TMAN_STATS_RETRIES; attempt++) {
+        uint32_t job_seq = task->JOB_SEQ;
+        uint32_t release_seq = task->RELEASE_SEQ;
+        if ((job_seq | release_seq) & 1)
+            continue;
+        TMAN_FENCE();
+
+        prvTMAN_StatsCopy(task, out);
+
+        TMAN_FENCE();
+        if (task->JOB_SEQ == job_seq && task->RELEASE_SEQ == release_seq)
+            return 1;
+    }
+
+    return 0;
 }
 
 /********************************************************************
- * Function: 	TMAN_TaskAdd()
+ * Function: 	TMAN_TaskStatsEx()
  * Precondition: 
- * Input:        taskName 
+ * Input: 		task handle, caller-owned stats struct
  * Returns:      TMAN_SUCCESS if Ok.
+ *               TMAN_FAIL_TASK_NOT_ADDED if the handle is not in use
+ *               TMAN_FAIL if the task was mid-update on every attempt
  * Side Effects:	 
- * Overview:     Add a task to the framework.
+ * Overview:     Consistent snapshot of the statistics of a task (see
+ *               tman_stats_t), times in microseconds.
  *		
- * Note:		 	
+ * Note:		 	Reentrant and lock-free: no critical section, callable
+ *               from an ISR. A reader that interrupted the writer can
+ *               not see it finish, hence the bounded retries; try
+ *               again later on TMAN_FAIL.
  * 
  ********************************************************************/
 
-int TMAN_TaskAdd(char taskName[]) {
+int TMAN_TaskStatsEx(tman_handle_t task, tman_stats_t *out) {
 
-    strcpy(tman_task_list[last_index++].NAME, taskName);
-    printf("Task <%s> adicionada.\n\r", taskName);
-    return TMAN_SUCCESS;
+    if (task == NULL || !task->IN_USE)
+        return TMAN_FAIL_TASK_NOT_ADDED;
+
+    return prvTMAN_StatsFill(task, out) ? TMAN_SUCCESS : TMAN_FAIL;
 }
 
 /********************************************************************
- * Function: 	TMAN_TaskRegisterAttributes()
+ * Function: 	TMAN_StatsSnapshot()
  * Precondition: 
- * Input: 		 taskName, attribute, value of the attribute
- * Attributes:   PERIOD, PHASE, DEADLINE, PRECEDENCE CONSTRAINTS
- * 
- * Returns:      TMAN_SUCCESS if Ok.
- *               TMAN_FAIL error code in case of failure (see tman.h)
- *               TMAN_FAIL_INVALID_ATTRIBUTE if attribute is not valid.
- *               TMAN_FAIL_TASK_NOT_ADDED if task was not added 
- *                                        to the framework
+ * Input: 		handles[] and out[] arrays of max entries
+ * Returns:      Number of tasks written.
  * Side Effects:	 
- * Overview:     Register attributes (period, phase, deadline, 
- *               precedence constraints) for a task already added to 
- *               the framework.
+ * Overview:     Statistics of every task in one pass. handles[k] (may
+ *               be NULL) identifies the task of out[k].
  *		
- * Note:		 	
+ * Note:		 	Lock-free, each entry is consistent on its own. A task
+ *               caught mid-update on every attempt is left out.
  * 
  ********************************************************************/
 
-int TMAN_TaskRegisterAttributes(char taskName[], char attribute[], char value[]){
-    
-    for (int i = 0; i < ARRAY_SIZE; i++) {
-        if (strcmp(tman_task_list[i].NAME, taskName) == 0) {
-            if (strcmp(attribute, "PERIOD") == 0) {
-                tman_task_list[i].PERIOD = atoi(value);
-                if (!(tman_task_list[i].DEADLINE > 0))
-                    tman_task_list[i].DEADLINE = atoi(value);
-            } else if (strcmp(attribute, "PHASE") == 0) {
-                tman_task_list[i].PHASE = atoi(value);
-            } else if (strcmp(attribute, "DEADLINE") == 0) {
-                tman_task_list[i].DEADLINE = atoi(value);
-            } else if (strcmp(attribute, "PRECEDENCE") == 0) {
-                // Verify if value is actually a task_name that exists, if not return TMAN_FAIL
-                
-                for (int j = 0; j < ARRAY_SIZE; j++) {
-                    if (strcmp(tman_task_list[j].NAME, value) == 0) {
-                        strcpy(tman_task_list[i].PRECEDENCE, value);
-                        tman_task_list[j].SEMAPHORE = xSemaphoreCreateBinary(); // Create semaphore
-                        tman_task_list[j].IS_PRECEDENT = 1;
-                        return TMAN_SUCCESS;
-                    }
+int TMAN_StatsSnapshot(tman_handle_t handles[], tman_stats_t out[], int max) {
+
+    int n = 0;
+
+    for (int i = 0; i < TMAN_MAX_TASKS && n < max; i++) {
+        if (!tman_task_list[i].IN_USE)
+            continue;
+        if (!prvTMAN_StatsFill(&tman_task_list[i], &out[n]))
+            continue;
+        if (handles != NULL)
+            handles[n] = &tman_task_list[i];
+        n++;
+    }
+
+    return n;
+}
+
+/********************************************************************
+ * Function: 	TMAN_CheckFeasibility()
+ * Precondition: FreeRTOS tasks created, WCET registered
+ * Input: 		policy (TMAN_POLICY_FIXED_PRIORITY or TMAN_POLICY_EDF)
+ * Returns:      TMAN_SUCCESS if the periodic tasks are schedulable.
+ *               TMAN_FAIL_NOT_FEASIBLE if some task can miss its deadline
+ *               TMAN_FAIL if a task has no FreeRTOS task yet
+ * Side Effects:	 With fixed priorities, sets the WCRT of each task
+ *               (TMAN_ANALYSIS_UNBOUNDED if it can miss its deadline).
+ * Overview:     Schedulability analysis of the current task set:
+ *               exact response-time analysis with the priorities the
+ *               tasks were created with, or processor-demand analysis
+ *               for EDF.
+ *		
+ * Note:		 	Precedence waits and TMAN overhead are not modelled.
+ * 
+ ********************************************************************/
+
+int TMAN_CheckFeasibility(int policy) {
+
+    static tman_analysis_task set[TMAN_MAX_TASKS];
+    const uint64_t tick_us = (uint64_t) tman_period * TMAN_US_PER_TICK;
+    int n = 0;
+
+    for (int i = 0; i < TMAN_MAX_TASKS; i++) {
+        task_tman *task = &tman_task_list[i];
+        if (!task->IN_USE || task->PERIOD <= 0)
+            continue;
+
+        if (task->TASK_HANDLE == NULL)
+            prvTMAN_Bind(task, xTaskGetHandle(task->NAME));
+        if (task->TASK_HANDLE == NULL && task->JOB_FN == NULL)
+            return TMAN_FAIL;
+
+        set[n].PERIOD = task->PERIOD * tick_us;
+        set[n].DEADLINE = task->DEADLINE * tick_us;
+        set[n].WCET = task->WCET;
+        set[n].BLOCKING = TMAN_TaskGetBlocking(task);
+        set[n].PRIORITY = prvTMAN_Priority(task);
+        set[n].ID = i;
+        n++;
+    }
+
+    if (policy == TMAN_POLICY_EDF)
+        return TMAN_AnalysisEDF(set, n) == 0 ? TMAN_SUCCESS : TMAN_FAIL_NOT_FEASIBLE;
+
+    int misses = TMAN_AnalysisRTA(set, n);
+    for (int k = 0; k < n; k++)
+        tman_task_list[set[k].ID].WCRT = set[k].RESPONSE;
+
+    return misses == 0 ? TMAN_SUCCESS : TMAN_FAIL_NOT_FEASIBLE;
+}
+
+/* Rate/deadline monotonic levels (0 = highest) in topological order.
+ * A task inherits the key of its most urgent dependent, and a producer
+ * with the key of its consumer gets the level above it. */
+static int prvTMAN_AssignMonotonic(task_tman *order[], int n, int by_deadline, int level[]) {
+    static uint64_t key[TMAN_MAX_TASKS];
+    static task_tman *rank[TMAN_MAX_TASKS];
+
+    for (int k = n - 1; k >= 0; k--) {
+        task_tman *task = order[k];
+        int value = by_deadline ? task->DEADLINE : task->PERIOD;
+        uint64_t own = value > 0 ? (uint64_t) value : UINT64_MAX;
+
+        for (int j = 0; j < task->NUM_SUCCESSORS; j++) {
+            uint64_t succ = key[task->SUCCESSORS[j] - tman_task_list];
+            if (succ < own)
+                own = succ;
+        }
+        key[task - tman_task_list] = own;
+    }
+
+    // Stable insertion sort: ties keep the topological order. Runs once.
+    for (int k = 0; k < n; k++) {
+        task_tman *task = order[k];
+        int j = k;
+        while (j > 0 && key[rank[j - 1] - tman_task_list] > key[task - tman_task_list]) {
+            rank[j] = rank[j - 1];
+            j--;
+        }
+        rank[j] = task;
+    }
+
+    int current = -1;
+    for (int k = 0; k < n; k++) {
+        task_tman *task = rank[k];
+        int split = k == 0 || key[task - tman_task_list] != key[rank[k - 1] - tman_task_list];
+
+        for (int j = 0; j < task->NUM_PREDECESSORS && !split; j++)
+            split = level[task->PREDECESSORS[j] - tman_task_list] == current;
+        if (split)
+            current++;
+        level[task - tman_task_list] = current;
+    }
+
+    return current + 1;
+}
+
+/* Do all the tasks on trial (PRIORITY 0) meet their deadlines? */
+static int prvTMAN_LevelFeasible(const tman_analysis_task set[], int n) {
+    for (int k = 0; k < n; k++) {
+        if (set[k].PRIORITY == 0 && TMAN_AnalysisResponse(set, n, k) == TMAN_ANALYSIS_UNBOUNDED)
+            return 0;
+    }
+    return 1;
+}
+
+/* Audsley's assignment, filled from the lowest level up. Each level takes
+ * every remaining task that still meets its deadline there, and only
+ * tasks whose dependents all sit on lower levels are tried. Returns the
+ * number of levels, -1 if some level stays empty. */
+static int prvTMAN_AssignOpa(task_tman *order[], int n, int level[]) {
+    static tman_analysis_task set[TMAN_MAX_TASKS];
+    static int pending[TMAN_MAX_TASKS];
+    static int bottom[TMAN_MAX_TASKS];
+    const uint64_t tick_us = (uint64_t) tman_period * TMAN_US_PER_TICK;
+
+    for (int k = 0; k < n; k++) {
+        set[k].PERIOD = order[k]->PERIOD * tick_us;
+        set[k].DEADLINE = order[k]->DEADLINE * tick_us;
+        set[k].WCET = order[k]->WCET;
+        set[k].BLOCKING = 0;    // ceilings follow the levels being assigned
+        set[k].PRIORITY = 1;    // unassigned: above every level built so far
+        set[k].ID = k;
+        pending[k] = order[k]->NUM_SUCCESSORS;
+    }
+
+    int levels = 0;
+    for (int placed = 0; placed < n; levels++) {
+        int members = 0;
+
+        // Consumers first: they are the ones allowed at low levels
+        for (int k = n - 1; k >= 0; k--) {
+            if (set[k].PRIORITY != 1 || pending[k] > 0)
+                continue;
+            set[k].PRIORITY = 0;
+            if (prvTMAN_LevelFeasible(set, n))
+                members++;
+            else
+                set[k].PRIORITY = 1;
+        }
+        if (members == 0)
+            return -1;
+
+        for (int k = 0; k < n; k++) {
+            if (set[k].PRIORITY != 0)
+                continue;
+            set[k].PRIORITY = -1;
+            bottom[k] = levels;
+            placed++;
+            for (int j = 0; j < order[k]->NUM_PREDECESSORS; j++) {
+                task_tman *pred = order[k]->PREDECESSORS[j];
+                for (int m = 0; m < n; m++) {
+                    if (order[m] == pred)
+                        pending[m]--;
                 }
-                
-                
-                return TMAN_FAIL;
-            } else {
-                return TMAN_FAIL_INVALID_ATTRIBUTE;
             }
-            return TMAN_SUCCESS;
         }
     }
-        
-    return TMAN_FAIL_TASK_NOT_ADDED;
 
+    for (int k = 0; k < n; k++)
+        level[order[k] - tman_task_list] = levels - 1 - bottom[k];
+    return levels;
 }
 
 /********************************************************************
- * Function: 	TMAN_TaskWaitPeriod()
- * Precondition: 
- * Input: 		 
- * Returns:      
- * Side Effects:	 
- * Overview:     Called by a task to signal the termination of an 
- *               instance and wait for the next activation.
+ * Function: 	TMAN_AssignPriorities()
+ * Precondition: TMAN_TaskRegisterAttributes() done for every task
+ * Input: 		mode: TMAN_MODE_ASSIGN_RM, TMAN_MODE_ASSIGN_DM or
+ *               TMAN_MODE_ASSIGN_OPA
+ * Returns:      TMAN_SUCCESS if Ok.
+ *               TMAN_FAIL_NOT_FEASIBLE if Audsley's assignment found
+ *               no feasible order (deadline monotonic is used instead)
+ *               TMAN_FAIL_PRIORITY_LEVELS if the order needs more
+ *               levels than tskIDLE_PRIORITY + 1 .. TMAN_PRIORITY - 1
+ *               (the lowest ones are merged)
+ * Side Effects:	 Changes the FreeRTOS priority of every TMAN task.
+ * Overview:     Priorities from the registered PERIOD (rate monotonic),
+ *               DEADLINE (deadline monotonic) or from response-time
+ *               analysis with WCET (Audsley). Producers always rank
+ *               at or above their consumers: a producer takes the
+ *               urgency of its most urgent dependent.
+ *		
+ * Note:		 	Called by the dispatcher at start in the
+ *               TMAN_MODE_ASSIGN_* modes. Audsley's assignment falls
+ *               back to deadline monotonic when a WCET is unknown.
+ *               Tasks created later get their priority when bound.
  * 
+ ********************************************************************/
+
+int TMAN_AssignPriorities(int mode) {
+
+    static task_tman *order[TMAN_MAX_TASKS];
+    static int level[TMAN_MAX_TASKS];
+    const int max_levels = TMAN_PRIORITY - 1 - tskIDLE_PRIORITY;
+    int result = TMAN_SUCCESS;
+    int levels = -1;
+
+    int n = prvTMAN_TopoOrder(order);
+
+    mode &= TMAN_MODE_ASSIGN_MASK;
+    if (mode == TMAN_MODE_ASSIGN_OPA) {
+        int known = 1;
+        for (int k = 0; k < n; k++)
+            known = known && order[k]->WCET > 0 && order[k]->PERIOD > 0 && order[k]->DEADLINE > 0;
+
+        if (known) {
+            levels = prvTMAN_AssignOpa(order, n, level);
+            if (levels < 0)
+                result = TMAN_FAIL_NOT_FEASIBLE;
+        }
+    }
+    if (levels < 0)
+        levels = prvTMAN_AssignMonotonic(order, n, mode != TMAN_MODE_ASSIGN_RM, level);
+
+    if (levels > max_levels)
+        result = TMAN_FAIL_PRIORITY_LEVELS;
+
+    for (int k = 0; k < n; k++) {
+        task_tman *task = order[k];
+        int lvl = level[task - tman_task_list];
+
+        if (lvl > max_levels - 1)
+            lvl = max_levels - 1;
+        task->ASSIGNED_PRIORITY = TMAN_PRIORITY - 1 - lvl;
+
+        if (task->TASK_HANDLE == NULL)
+            prvTMAN_Bind(task, xTaskGetHandle(task->NAME));
+        else
+            vTaskPrioritySet(task->TASK_HANDLE, task->ASSIGNED_PRIORITY);
+    }
+
+    return result;
+}
+
+/********************************************************************
+ * Function: 	TMAN_TaskGetWcrt()
+ * Precondition: TMAN_CheckFeasibility(TMAN_POLICY_FIXED_PRIORITY)
+ * Input: 		task handle
+ * Returns:      Worst-case response time in microseconds,
+ *               TMAN_ANALYSIS_UNBOUNDED if it can miss its deadline,
+ *               0 if the handle is not in use or was never analysed.
+ * Side Effects:	 
+ * Overview:     Result of the last response-time analysis.
  *		
  * Note:		 	
  * 
  ********************************************************************/
 
-int TMAN_TaskWaitPeriod(char * pvParameters){
+uint64_t TMAN_TaskGetWcrt(tman_handle_t task) {
+    if (task == NULL || !task->IN_USE)
+        return 0;
+    return task->WCRT;
+}
+
+/********************************************************************
+ * Function: 	TMAN_TaskGetExecTime()
+ * Precondition: 
+ * Input: 		task handle, pointers for min, max and mean (may be NULL)
+ * Returns:      TMAN_SUCCESS if Ok.
+ *               TMAN_FAIL_TASK_NOT_ADDED if the handle is not in use
+ *               TMAN_FAIL if no job completed yet, or the task was
+ *                         mid-update on every attempt
+ * Side Effects:	 
+ * Overview:     Execution time of the completed jobs of a task, in
+ *               microseconds, measured with the core timer.
+ *		
+ * Note:		 	Time spent preempted is excluded when the context
+ *               switch trace hooks are enabled (see FreeRTOSConfig.h).
+ *               Lock-free, read like TMAN_TaskStatsEx().
+ * 
+ ********************************************************************/
 
-    for (int i = 0; i < ARRAY_SIZE; i++) {
-        
-        if (strcmp(tman_task_list[i].NAME, pvParameters) == 0) {
+int TMAN_TaskGetExecTime(tman_handle_t task, uint32_t *min, uint32_t *max, uint32_t *mean) {
+    uint32_t jobs = 0, exec_min = 0, exec_max = 0;
+    uint64_t exec_sum = 0;
+    int consistent = 0;
 
-            if (tman_task_list[i].NUM_ACTIVATIONS > 0) {
+    if (task == NULL || !task->IN_USE)
+        return TMAN_FAIL_TASK_NOT_ADDED;
 
-                // If it does precedence
-                if (tman_task_list[i].IS_PRECEDENT == 1)
-                    xSemaphoreGive(tman_task_list[i].SEMAPHORE);
-                
-                // If fails Deadline
-                if (tman_ticks - tman_task_list[i].LAST_ACTIVATION > tman_task_list[i].DEADLINE){
-                    
-                    tman_task_list[i].DEADLINE_MISSES++;            
-                }
-            }
-            break;
-        }
+    for (int attempt = 0; attempt < TMAN_STATS_RETRIES && !consistent; attempt++) {
+        uint32_t job_seq = task->JOB_SEQ;
+        if (job_seq & 1)
+            continue;
+        TMAN_FENCE();
+
+        jobs = task->EXEC_COUNT;
+        exec_min = task->EXEC_MIN;
+        exec_max = task->EXEC_MAX;
+        exec_sum = task->EXEC_SUM;
+
+        TMAN_FENCE();
+        consistent = task->JOB_SEQ == job_seq;
     }
-//    
-    TaskHandle_t task_handle = xTaskGetHandle(pvParameters);    
-    vTaskSuspend(task_handle);
 
-    
-    for (int i = 0; i < ARRAY_SIZE; i++) {
-        if (strcmp(tman_task_list[i].NAME, pvParameters) == 0) {
-            
-            tman_task_list[i].LAST_ACTIVATION = tman_ticks;
-            
-            // If it has precedence
-            if (tman_task_list[i].PRECEDENCE != NULL) {
-                // Has to take semaphore of the precedence_constraint task
-                for (int j = 0; j < ARRAY_SIZE; j++) {
-
-                    // if we found the task which is the precedence
-                    if (strcmp(tman_task_list[i].PRECEDENCE, tman_task_list[j].NAME) == 0) {
-                        xSemaphoreTake(tman_task_list[j].SEMAPHORE, portMAX_DELAY);
-                        break;
-                    }
-                }
-            }
-            
-            tman_task_list[i].NUM_ACTIVATIONS++;
+    if (!consistent || jobs == 0)
+        return TMAN_FAIL;
 
-            break;
-        }
+    if (min != NULL)
+        *min = (uint64_t) exec_min * 1000000 / TMAN_TIMESTAMP_HZ;
+    if (max != NULL)
+        *max = (uint64_t) exec_max * 1000000 / TMAN_TIMESTAMP_HZ;
+    if (mean != NULL)
+        *mean = exec_sum / jobs * 1000000 / TMAN_TIMESTAMP_HZ;
+
+    return TMAN_SUCCESS;
+}
+
+#if TMAN_RESPONSE_HISTOGRAM
+/********************************************************************
+ * Function: 	TMAN_TaskGetResponseQuantile()
+ * Precondition: 
+ * Input: 		task handle, quantile in basis points (p50 = 5000,
+ *               p99 = 9900, p99.9 = 9990), pointer for the result
+ * Returns:      TMAN_SUCCESS if Ok.
+ *               TMAN_FAIL_TASK_NOT_ADDED if the handle is not in use
+ *               TMAN_FAIL if no job completed yet, or the task was
+ *                         mid-update on every attempt
+ *               TMAN_FAIL_INVALID_ATTRIBUTE if basis_points > 10000
+ * Side Effects:	 
+ * Overview:     Response time quantile of a task, in microseconds,
+ *               estimated from its log-bucketed histogram (within
+ *               6.25% of the exact value), clamped to the observed
+ *               min and max.
+ *		
+ * Note:		 	O(TMAN_HIST_BUCKETS), meant for monitoring rather than
+ *               the job path. Lock-free, read like TMAN_TaskStatsEx().
+ * 
+ ********************************************************************/
+
+int TMAN_TaskGetResponseQuantile(tman_handle_t task, uint32_t basis_points, uint32_t *us) {
+    uint32_t jobs = 0, quantile = 0, min = 0, max = 0;
+    int consistent = 0;
+
+    if (task == NULL || !task->IN_USE)
+        return TMAN_FAIL_TASK_NOT_ADDED;
+    if (basis_points > 10000)
+        return TMAN_FAIL_INVALID_ATTRIBUTE;
+
+    // The histogram is walked in place, a torn walk is discarded
+    for (int attempt = 0; attempt < TMAN_STATS_RETRIES && !consistent; attempt++) {
+        uint32_t job_seq = task->JOB_SEQ;
+        if (job_seq & 1)
+            continue;
+        TMAN_FENCE();
+
+        jobs = task->EXEC_COUNT;
+        quantile = TMAN_HistogramQuantile(&task->RESPONSE_HIST, basis_points);
+        min = prvTMAN_CountsToUs(task->RESPONSE_MIN);
+        max = prvTMAN_CountsToUs(task->RESPONSE_MAX);
+
+        TMAN_FENCE();
+        consistent = task->JOB_SEQ == job_seq;
     }
-    
+
+    if (!consistent || jobs == 0)
+        return TMAN_FAIL;
+
+    // A bucket's midpoint can lie past the extreme samples it holds
+    if (quantile > max)
+        quantile = max;
+    if (quantile < min)
+        quantile = min;
+    *us = quantile;
+    return TMAN_SUCCESS;
 }
+#endif
 
 /********************************************************************
- * Function: 	TMAN_TaskStats()
+ * Function: 	TMAN_LogWrite()
  * Precondition: 
- * Input: 		char taskName[]
- * Returns:      returns statistical information about a task. 
+ * Input: 		format (must outlive the message), number of arguments,
+ *               arguments
+ * Returns:      TMAN_SUCCESS if Ok.
+ *               TMAN_FAIL if the buffer was full and the message dropped
  * Side Effects:	 
- * Overview:     returns statistical information about a task.
+ * Overview:     Back end of the TMAN_Log() macro: queues the message
+ *               with a core timer stamp for the console task.
  *		
- * Note:		 	
+ * Note:		 	Lock-free and constant time, callable from an ISR.
+ *               The stamp is printed in microseconds and wraps like
+ *               the core timer.
  * 
  ********************************************************************/
 
-int * TMAN_TaskStats(char taskName[]){
-    
-    static int ret[2];
-    
-    for (int i = 0; i < ARRAY_SIZE; i++) {
-        if (strcmp(tman_task_list[i].NAME, taskName) == 0) {
-            ret[0] = tman_task_list[i].NUM_ACTIVATIONS;
-            ret[1] = tman_task_list[i].DEADLINE_MISSES;
-            return ret;
+int TMAN_LogWrite(const char *format, int num_args, tman_log_arg_t a, tman_log_arg_t b,
+                  tman_log_arg_t c, tman_log_arg_t d) {
+
+    if (TMAN_LogPut(TMAN_TIMESTAMP(), format, num_args, a, b, c, d) != 0)
+        return TMAN_FAIL;
+    return TMAN_SUCCESS;
+}
+
+/********************************************************************
+ * Function: 	vTMAN_TaskSwitchedIn() / vTMAN_TaskSwitchedOut()
+ * Precondition: Called by the kernel from traceTASK_SWITCHED_IN/OUT
+ * Input: 		application tag of the task (its TMAN task, or NULL),
+ *               on switch-out whether the task is still ready
+ * Returns:      
+ * Side Effects:	 
+ * Overview:     Pause and resume the execution time of the running job
+ *               on every switch. Only a switch-out that leaves the task
+ *               ready is a preemption: counted and traced as one. A job
+ *               that blocks by itself (vTaskDelay(), a queue or
+ *               semaphore wait) is traced as TMAN_TRACE_BLOCK.
+ *		
+ * Note:		 	Runs inside the scheduler: no kernel calls.
+ * 
+ ********************************************************************/
+
+void vTMAN_TaskSwitchedIn(void *tag) {
+    task_tman *task = (task_tman *) tag;
+
+    if (task != NULL && task->JOB_ACTIVE) {
+        task->RUN_START = TMAN_TIMESTAMP();
+        TMAN_TRACE_EVENT(TMAN_TRACE_RESUME, task, 0);
+    }
+}
+
+void vTMAN_TaskSwitchedOut(void *tag, long still_ready) {
+    task_tman *task = (task_tman *) tag;
+
+    if (task != NULL && task->JOB_ACTIVE) {
+        task->JOB_EXEC += TMAN_TIMESTAMP() - task->RUN_START;
+        if (still_ready) {
+            task->PREEMPTIONS++;
+            TMAN_TRACE_EVENT(TMAN_TRACE_PREEMPT, task, 0);
+        } else {
+            TMAN_TRACE_EVENT(TMAN_TRACE_BLOCK, task, 0);
         }
     }
-    
-    return ret;
 }
 
 /***************************************End Of File*************************************/
\ No newline at end of file
@@ -29,40 +29,486 @@
 #include "list.h"
 #include "semphr.h"
 
+#include "tman_histogram.h"
+#include "tman_log.h"
+
 
 // Define return codes
 #define TMAN_SUCCESS                     0
 #define TMAN_FAIL                       -1
 #define TMAN_FAIL_INVALID_ATTRIBUTE     -2
 #define TMAN_FAIL_TASK_NOT_ADDED        -3
-#define PRIORITY (tskIDLE_PRIORITY + 5)
+#define TMAN_FAIL_TASK_LIST_FULL        -4
+#define TMAN_FAIL_TASK_IN_USE           -5
+#define TMAN_FAIL_TABLE_OVERFLOW        -6
+#define TMAN_FAIL_PRECEDENCE_CYCLE      -7
+#define TMAN_FAIL_NOT_FEASIBLE          -8
+#define TMAN_FAIL_PRIORITY_LEVELS       -9
+#define TMAN_FAIL_MODE_PENDING          -10
+
+// Modes for TMAN_InitMode()
+#define TMAN_MODE_EVENT                 0x00    // releases from the next-release queue
+#define TMAN_MODE_TIME_TRIGGERED        0x01    // releases from a precomputed hyperperiod table
+#define TMAN_MODE_EDF                   0x02    // earliest absolute deadline runs first
+#define TMAN_MODE_ASSIGN_RM             0x04    // priorities by period, set when TMAN starts
+#define TMAN_MODE_ASSIGN_DM             0x08    // priorities by deadline
+#define TMAN_MODE_ASSIGN_OPA            0x0C    // Audsley's optimal assignment, needs WCET
+#define TMAN_MODE_ASSIGN_MASK           0x0C
+
+// Priority of the TMAN dispatcher. Task priorities are assigned between
+// tskIDLE_PRIORITY + 1 and TMAN_PRIORITY - 1, raise it for more levels.
+#ifndef TMAN_PRIORITY
+#define TMAN_PRIORITY                   (tskIDLE_PRIORITY + 5)
+#endif
+
+// Stack of the dispatcher, in words. Its deepest path is the self-test
+// report (sprintf() with a stats snapshot on the stack), the dispatcher
+// prints its high-water mark with it to check the size on the board.
+#ifndef TMAN_DISPATCHER_STACK
+#define TMAN_DISPATCHER_STACK           (2 * configMINIMAL_STACK_SIZE)
+#endif
+
+// Capacity of the task registry, set at build time (e.g. -DTMAN_MAX_TASKS=512)
+#ifndef TMAN_MAX_TASKS
+#define TMAN_MAX_TASKS                  6
+#endif
+
+// Precedence graph fan-in and fan-out per task
+#ifndef TMAN_MAX_PREDECESSORS
+#define TMAN_MAX_PREDECESSORS           4
+#endif
+#ifndef TMAN_MAX_SUCCESSORS
+#define TMAN_MAX_SUCCESSORS             4
+#endif
+
+// Scheduling policies for TMAN_CheckFeasibility()
+#define TMAN_POLICY_FIXED_PRIORITY      0
+#define TMAN_POLICY_EDF                 1
+
+// What TMAN does when a job is still pending at its deadline instant
+// (OVERRUN attribute, TMAN_TaskSetOverrunPolicy()). The miss is counted
+// in every case.
+#define TMAN_OVERRUN_CONTINUE           0       // let the late job finish
+#define TMAN_OVERRUN_SKIP               1       // drop the next release
+#define TMAN_OVERRUN_ABORT              2       // flag the job to end, see TMAN_TaskAborted()
+#define TMAN_OVERRUN_HANDLER            3       // call the task's overrun handler
+
+// What a release does while earlier jobs of the task are still
+// outstanding (BACKLOG attribute, TMAN_TaskSetBacklog())
+#define TMAN_BACKLOG_QUEUE              0       // queue up to a depth, drop beyond
+#define TMAN_BACKLOG_COALESCE           1       // a job waiting to start takes the newest release
+#define TMAN_BACKLOG_DROP               2       // drop releases until the job completes
+
+// Default depth of TMAN_BACKLOG_QUEUE: jobs released and not yet
+// completed, the running one included
+#ifndef TMAN_BACKLOG_DEPTH
+#define TMAN_BACKLOG_DEPTH              4
+#endif
+
+// Deepest backlog TMAN_TaskSetBacklog() accepts: the release of each
+// outstanding job is kept, so each one is held to its own deadline
+#ifndef TMAN_BACKLOG_MAX
+#define TMAN_BACKLOG_MAX                8
+#endif
+#if TMAN_BACKLOG_DEPTH > TMAN_BACKLOG_MAX
+#error "TMAN_BACKLOG_DEPTH above TMAN_BACKLOG_MAX"
+#endif
+
+// What TMAN does with a job that used up its CPU budget (BUDGET attribute,
+// TMAN_TaskSetBudget()), until the job completes or the next release of
+// the task gives it a new budget. The overrun is counted in both cases.
+#define TMAN_BUDGET_DEMOTE              0       // run on at TMAN_BUDGET_PRIORITY
+#define TMAN_BUDGET_SUSPEND             1       // suspend the task
+
+// Background priority of demoted jobs
+#ifndef TMAN_BUDGET_PRIORITY
+#define TMAN_BUDGET_PRIORITY            tskIDLE_PRIORITY
+#endif
+
+// Shared resources under the immediate priority ceiling protocol
+// (TMAN_ResourceDeclare()), and the tasks declared to use each
+#ifndef TMAN_MAX_RESOURCES
+#define TMAN_MAX_RESOURCES              4
+#endif
+#ifndef TMAN_RESOURCE_USERS
+#define TMAN_RESOURCE_USERS             TMAN_MAX_TASKS
+#endif
+
+// Aperiodic servers (TMAN_ServerCreate()): a periodic TMAN task that runs
+// submitted jobs with a budget of execution time per period
+#define TMAN_SERVER_POLLING             0       // serves what is queued at its release, the rest of the budget is lost
+#define TMAN_SERVER_DEFERRABLE          1       // keeps the budget through the period for jobs that arrive later
+
+// Jobs a server queue holds, and the stack they run on
+#ifndef TMAN_SERVER_QUEUE
+#define TMAN_SERVER_QUEUE               8
+#endif
+#ifndef TMAN_SERVER_STACK
+#define TMAN_SERVER_STACK               (2 * configMINIMAL_STACK_SIZE)
+#endif
+
+// Run-to-completion jobs (TMAN_JobAdd()): called from one executor task
+// per priority band, band b at TMAN_EXECUTOR_PRIORITY + b. The jobs of a
+// band share the executor's stack and do not preempt each other.
+#ifndef TMAN_EXECUTOR_BANDS
+#define TMAN_EXECUTOR_BANDS             2
+#endif
+#ifndef TMAN_EXECUTOR_PRIORITY
+#define TMAN_EXECUTOR_PRIORITY          ( tskIDLE_PRIORITY + 1 )
+#endif
+#ifndef TMAN_EXECUTOR_STACK
+#define TMAN_EXECUTOR_STACK             (2 * configMINIMAL_STACK_SIZE)
+#endif
+
+// Operating modes (alternative task sets) TMAN_ModeDefine() can hold
+#ifndef TMAN_MAX_MODES
+#define TMAN_MAX_MODES                  3
+#endif
+
+// Safe points for TMAN_ModeSwitch(). Either waits for an instant with no
+// job outstanding, so the old mode's jobs all complete and the new mode
+// releases from a clean slate.
+#define TMAN_SWITCH_IDLE                0       // first idle instant
+#define TMAN_SWITCH_HYPERPERIOD         1       // first idle hyperperiod boundary of the current mode
+
+// Priorities used in TMAN_MODE_EDF: the earliest deadline pending job
+// runs at HIGH, every other TMAN task at LOW. Both below TMAN_PRIORITY.
+#ifndef TMAN_EDF_PRIORITY_HIGH
+#define TMAN_EDF_PRIORITY_HIGH          (TMAN_PRIORITY - 1)
+#endif
+#ifndef TMAN_EDF_PRIORITY_LOW
+#define TMAN_EDF_PRIORITY_LOW           (tskIDLE_PRIORITY + 1)
+#endif
+
+// Distinct release instants the time-triggered table holds per hyperperiod
+#ifndef TMAN_TT_TABLE_SIZE
+#define TMAN_TT_TABLE_SIZE              32
+#endif
+
+// Set to 1 to activate tasks with vTaskSuspend()/vTaskResume() instead of
+// counted task notifications. Kept only to compare release-to-run latency,
+// a release that arrives between job completion and the suspend is lost.
+#ifndef TMAN_ACTIVATION_SUSPEND
+#define TMAN_ACTIVATION_SUSPEND         0
+#endif
 
-#define ARRAY_SIZE                      6
+// Read attempts of a stats snapshot before giving up on a writer that
+// is stuck mid-update (the reader preempted it, or runs in an ISR)
+#ifndef TMAN_STATS_RETRIES
+#define TMAN_STATS_RETRIES              8
+#endif
+
+// Demo self-test: after this many TMAN ticks the dispatcher prints the
+// stats of task "B" and ends the scheduler. 0 keeps TMAN running.
+#ifndef TMAN_SELFTEST_TICKS
+#define TMAN_SELFTEST_TICKS             20
+#endif
+
+// Set to 1 to record scheduling events in a binary ring (tman_trace.h)
+// and stream them over the UART from the console task.
+// Decode the capture on the host with tools/tman_trace_decode.c.
+#ifndef TMAN_TRACE
+#define TMAN_TRACE                      0
+#endif
+
+// Set to 0 to compile TMAN_Log() out
+#ifndef TMAN_LOG
+#define TMAN_LOG                        1
+#endif
+
+// The console task formats TMAN_Log() messages and drains the trace at
+// idle priority, polling with this period
+#ifndef TMAN_CONSOLE_PERIOD_MS
+#define TMAN_CONSOLE_PERIOD_MS          20
+#endif
+#ifndef TMAN_LOG_LINE
+#define TMAN_LOG_LINE                   96
+#endif
+
+// Set to 0 to drop the per-task response time histogram (TMAN_HIST_BUCKETS
+// 16-bit counters per task) and TMAN_TaskGetResponseQuantile().
+#ifndef TMAN_RESPONSE_HISTOGRAM
+#define TMAN_RESPONSE_HISTOGRAM         1
+#endif
+
+// TMAN_Log(format, up to 4 arguments): printf-like, but only the format
+// pointer, a timestamp and the raw arguments are queued, the console task
+// formats and prints them later. Arguments are integers, chars or
+// pointers to strings that outlive the message (literals, task names).
+// A full buffer drops the message and counts it.
+#if TMAN_LOG
+#define TMAN_Log(...)                   TMAN_LOG_PICK(__VA_ARGS__, TMAN_LOG_4, TMAN_LOG_3, TMAN_LOG_2, TMAN_LOG_1, TMAN_LOG_0, _)(__VA_ARGS__)
+#else
+#define TMAN_Log(...)                   do { } while (0)
+#endif
+#define TMAN_LOG_PICK(f, a, b, c, d, macro, ...)    macro
+#define TMAN_LOG_0(f)                   TMAN_LogWrite(f, 0, 0, 0, 0, 0)
+#define TMAN_LOG_1(f, a)                TMAN_LogWrite(f, 1, (tman_log_arg_t) (a), 0, 0, 0)
+#define TMAN_LOG_2(f, a, b)             TMAN_LogWrite(f, 2, (tman_log_arg_t) (a), (tman_log_arg_t) (b), 0, 0)
+#define TMAN_LOG_3(f, a, b, c)          TMAN_LogWrite(f, 3, (tman_log_arg_t) (a), (tman_log_arg_t) (b), (tman_log_arg_t) (c), 0)
+#define TMAN_LOG_4(f, a, b, c, d)       TMAN_LogWrite(f, 4, (tman_log_arg_t) (a), (tman_log_arg_t) (b), (tman_log_arg_t) (c), (tman_log_arg_t) (d))
+
+// TMAN time base, in TMAN ticks. 64-bit so that long uptimes never wrap.
+typedef uint64_t tman_time_t;
+
+struct task_tman;
+
+// Called by the dispatcher, at TMAN_PRIORITY, when a job of the task
+// misses its deadline. Keep it short: releases wait for it.
+typedef void (*tman_overrun_handler_t)(struct task_tman *task);
+
+// Job run to completion by a server or an executor
+typedef void (*tman_job_fn_t)(void *arg);
 
 typedef struct task_tman {
     char NAME[16];
     int PERIOD;
     int PHASE;
     int DEADLINE;
-    int DEADLINE_MISSES;
-    char PRECEDENCE[16];
+    int WCET;                   // worst-case execution time, in microseconds
+    tman_time_t ORIGIN;         // releases at ORIGIN + PHASE + k * PERIOD, moved by mode switches
+    uint64_t WCRT;              // worst-case response time from TMAN_CheckFeasibility(), in microseconds
+    int DEADLINE_MISSES;        // counted by the dispatcher at the deadline instant
     int NUM_ACTIVATIONS;
-    int LAST_ACTIVATION;
-    SemaphoreHandle_t SEMAPHORE;
-    int IS_PRECEDENT;
+    tman_time_t LAST_ACTIVATION;
+    struct task_tman *PREDECESSORS[TMAN_MAX_PREDECESSORS];
+    int EDGE_TOKENS[TMAN_MAX_PREDECESSORS]; // predecessor jobs completed, not yet consumed
+    int NUM_PREDECESSORS;
+    int READY_EDGES;            // predecessors with at least one token
+    struct task_tman *SUCCESSORS[TMAN_MAX_SUCCESSORS];
+    int NUM_SUCCESSORS;
+    SemaphoreHandle_t JOIN;     // given once per complete set of predecessor jobs
+    tman_time_t NEXT_RELEASE;   // absolute TMAN tick of the next release
+    int HEAP_INDEX;             // position in the release queue, -1 if absent
+    tman_time_t ABS_DEADLINE;   // absolute TMAN tick deadline of the pending job (EDF)
+    int EDF_INDEX;              // position in the EDF deadline queue, -1 if absent
+    tman_time_t DEADLINE_AT;    // absolute TMAN tick deadline of the watched job
+    int WATCH_INDEX;            // position in the deadline watch queue, -1 if absent
+    int LATE;                   // the oldest pending job passed its deadline
+    int OVERRUN_POLICY;         // TMAN_OVERRUN_*
+    tman_overrun_handler_t OVERRUN_HANDLER;
+    volatile int SKIP_NEXT;     // drop the next release (TMAN_OVERRUN_SKIP)
+    volatile int ABORT;         // the running job should end (TMAN_OVERRUN_ABORT)
+    uint32_t SKIPPED_RELEASES;
+    uint32_t ABORTED_JOBS;
+    int BACKLOG_POLICY;         // TMAN_BACKLOG_*
+    int BACKLOG_DEPTH;
+    int OUTSTANDING;            // jobs released and not completed yet
+    tman_time_t JOB_RELEASE[TMAN_BACKLOG_MAX];  // release of each outstanding job, the oldest at JOB_HEAD
+    uint32_t JOB_STAMP[TMAN_BACKLOG_MAX];       // core timer count at the same releases
+    int JOB_HEAD;
+    uint32_t QUEUED_RELEASES;   // released behind an unfinished job
+    uint32_t COALESCED_RELEASES;
+    uint32_t DROPPED_RELEASES;
+    int SPORADIC;               // released by TMAN_TaskTrigger(), PERIOD is the minimum inter-arrival time
+    uint32_t TRIGGER_STAMP;     // core timer count of the latest trigger (ISR side)
+    uint32_t PENDING_STAMP;     // the same for the release queued by the dispatcher, 0 if held back
+    uint32_t DEFERRED_RELEASES; // triggers held back to keep the minimum inter-arrival time
+    volatile uint32_t MERGED_TRIGGERS;  // triggers folded into one already pending
+    int BUDGET;                 // CPU time per job, in microseconds, 0 if unlimited
+    int BUDGET_POLICY;          // TMAN_BUDGET_*
+    uint64_t BUDGET_AT;         // kernel tick the budget of the job is checked next
+    int BUDGET_INDEX;           // position in the budget watch queue, -1 if absent
+    int LOCKS;                  // TMAN resources held by the running job
+    volatile int THROTTLED;     // the job used up its budget, demoted or suspended
+    UBaseType_t SAVED_PRIORITY; // priority of a demoted job before it was demoted
+    uint32_t BUDGET_OVERRUNS;
+    QueueHandle_t SERVER_QUEUE; // aperiodic jobs waiting, NULL if not a server
+    int SERVER_POLICY;          // TMAN_SERVER_*, the budget is WCET
+    uint32_t APERIODIC_JOBS;    // served so far
+    uint32_t APERIODIC_RESPONSE_MAX;    // submission to completion, in core timer counts
+    uint64_t APERIODIC_RESPONSE_SUM;
+    volatile uint32_t APERIODIC_DROPPED;    // submissions refused, queue full
+    tman_job_fn_t JOB_FN;       // run-to-completion job (TMAN_JobAdd()), NULL for a task
+    void *JOB_ARG;
+    int BAND;                   // executor of the job
+    TaskHandle_t TASK_HANDLE;   // cached kernel handle, NULL for a job
+    UBaseType_t ASSIGNED_PRIORITY;  // from TMAN_AssignPriorities(), 0 if none
+    volatile uint32_t RELEASE_SEQ;  // odd while the dispatcher updates the release fields
+    volatile uint32_t JOB_SEQ;  // odd while the task updates its job fields
+    uint32_t RELEASE_STAMP;     // core timer count at the last release (jitter)
+    uint32_t LATENCY_MAX;       // worst release-to-run latency, in core timer counts
+    uint32_t EXEC_MIN;          // execution time of completed jobs, in core timer counts
+    uint32_t EXEC_MAX;
+    uint64_t EXEC_SUM;
+    uint32_t EXEC_COUNT;        // completed jobs
+    uint32_t RESPONSE_MIN;      // release to completion, in core timer counts
+    uint32_t RESPONSE_MAX;
+    uint64_t RESPONSE_SUM;
+#if TMAN_RESPONSE_HISTOGRAM
+    tman_histogram RESPONSE_HIST;   // response times, in microseconds
+#endif
+    uint32_t START_LATENCY_MAX; // release to job start (after precedence), in core timer counts
+    uint64_t START_LATENCY_SUM;
+    uint32_t JITTER_MAX;        // worst deviation of the inter-release interval, in core timer counts
+    uint32_t RELEASE_COUNT;
+    volatile uint32_t PREEMPTIONS;  // switches away from a running job that stays ready
+    volatile uint32_t JOB_EXEC; // execution time of the running job before its last preemption
+    volatile uint32_t RUN_START;    // core timer count when the job last got the CPU
+    volatile int JOB_ACTIVE;    // a job is between release and TMAN_TaskWaitPeriod()
+    int IN_USE;                 // slot holds a task added to the framework
+    int PAUSED;                 // releases suspended by TMAN_TaskPause()
+    struct task_tman *NEXT_FREE;    // free list link while the slot is unused
+    int TT_INDEX;               // bit of the task in the time-triggered table, -1 if absent
+    unsigned VISIT_MARK;        // graph traversal scratch
 } task_tman;
 
-static task_tman tman_task_list[ARRAY_SIZE];
+// Opaque handle returned by TMAN_TaskAdd()
+typedef struct task_tman * tman_handle_t;
 
-static int tman_period;
+// Shared resource, see TMAN_ResourceDeclare()
+typedef struct tman_resource {
+    char NAME[16];
+    task_tman *USERS[TMAN_RESOURCE_USERS];
+    uint32_t CS_US[TMAN_RESOURCE_USERS];    // longest critical section of each user, in microseconds
+    int NUM_USERS;
+    UBaseType_t CEILING;        // highest priority among the users
+    task_tman *OWNER;           // NULL while free
+    UBaseType_t SAVED_PRIORITY; // priority of the owner before it locked
+    SemaphoreHandle_t GUARD;    // never contended while the protocol holds
+    uint32_t CONTENTIONS;       // locks that found the guard taken
+    int IN_USE;
+} tman_resource;
+
+typedef struct tman_resource * tman_resource_t;
+
+// One task of a declarative task set, see TMAN_TASK_SET()
+typedef struct tman_task_def {
+    const char *NAME;
+    TaskFunction_t BODY;        // created with its handle as parameter, NULL if created elsewhere
+    UBaseType_t PRIORITY;
+    int PERIOD;
+    int PHASE;
+    int DEADLINE;               // 0: same as PERIOD
+    int WCET;                   // in microseconds, 0 if unknown
+    int PRECEDENCE;             // index of the predecessor in the set, -1 if none
+} tman_task_def;
+
+/* Declarative task set, validated at compile time and registered with
+ * TMAN_TaskSetLoad(set, set_COUNT, handles):
+ *
+ *   #define DEMO_TASKS(X, s) \
+ *       X(s, A, taskBody, PRIORITY_A, 1, 0, 1, 0, NONE) \
+ *       X(s, B, taskBody, PRIORITY_B, 1, 0, 1, 0, A)
+ *   TMAN_TASK_SET(demo, DEMO_TASKS, PERIOD_200MS);
+ *
+ * Fields: name, body, priority, PERIOD, PHASE, DEADLINE, WCET,
+ * predecessor (NONE for none). tick is the TMAN_Init() tick. demo_ID_A
+ * is the index of A in the set. The build fails on an unknown
+ * predecessor, a zero PERIOD, a DEADLINE longer than the PERIOD, or a
+ * WCET utilization above 1. */
+#define TMAN_TASK_SET(s, LIST, tick) \
+    enum { s##_ID_NONE = -1, LIST(TMAN_TS_ID, s) s##_COUNT }; \
+    enum { s##_TICK_US = (tick) * (1000000UL / configTICK_RATE_HZ) }; \
+    static const tman_task_def s[] = { LIST(TMAN_TS_ENTRY, s) }; \
+    LIST(TMAN_TS_CHECK, s) \
+    _Static_assert((0 LIST(TMAN_TS_LOAD, s)) <= 1000000ULL, \
+                   "TMAN task set " #s ": utilization above 1")
+#define TMAN_TS_ID(s, name, body, prio, period, phase, deadline, wcet, pred) \
+    s##_ID_##name,
+#define TMAN_TS_ENTRY(s, name, body, prio, period, phase, deadline, wcet, pred) \
+    { #name, body, prio, period, phase, deadline, wcet, s##_ID_##pred },
+#define TMAN_TS_CHECK(s, name, body, prio, period, phase, deadline, wcet, pred) \
+    _Static_assert((period) > 0, "TMAN task " #name ": PERIOD must be > 0"); \
+    _Static_assert((deadline) >= 0 && (deadline) <= (period), "TMAN task " #name ": DEADLINE longer than PERIOD"); \
+    _Static_assert(s##_ID_##pred != s##_ID_##name, "TMAN task " #name ": precedes itself");
+// Parts per million of the CPU, rounded up
+#define TMAN_TS_LOAD(s, name, body, prio, period, phase, deadline, wcet, pred) \
+    + ((period) > 0 ? ((wcet) * 1000000ULL + (period) * s##_TICK_US - 1) / ((period) * s##_TICK_US) : 0)
+
+// Task statistics snapshot, filled by TMAN_TaskStatsEx(). Times in microseconds.
+typedef struct tman_stats {
+    uint32_t ACTIVATIONS;
+    uint32_t DEADLINE_MISSES;
+    uint32_t COMPLETED_JOBS;
+    uint32_t RESPONSE_MIN;      // best-case response time
+    uint32_t RESPONSE_MAX;      // worst-case response time
+    uint32_t RESPONSE_AVG;
+    uint32_t EXEC_MIN;
+    uint32_t EXEC_MAX;
+    uint32_t EXEC_AVG;
+    uint32_t RELEASE_JITTER;    // worst deviation of the inter-release interval
+    uint32_t START_LATENCY_MAX; // release to job start, precedence waits included
+    uint32_t START_LATENCY_AVG;
+    uint32_t PREEMPTIONS;
+    uint32_t SKIPPED_RELEASES;  // dropped by TMAN_OVERRUN_SKIP
+    uint32_t ABORTED_JOBS;      // ended by TMAN_OVERRUN_ABORT
+    uint32_t QUEUED_RELEASES;   // waited behind an unfinished job
+    uint32_t COALESCED_RELEASES;    // merged into a job waiting to start
+    uint32_t DROPPED_RELEASES;  // lost to a full backlog or TMAN_BACKLOG_DROP
+    uint32_t BUDGET_OVERRUNS;   // jobs that used up their CPU budget
+    uint32_t DEFERRED_RELEASES; // sporadic triggers held back to the minimum inter-arrival time
+    uint32_t MERGED_TRIGGERS;   // sporadic triggers folded into a pending one
+    uint32_t APERIODIC_JOBS;    // served, for a server
+    uint32_t APERIODIC_RESPONSE_MAX;    // submission to completion
+    uint32_t APERIODIC_RESPONSE_AVG;
+    uint32_t APERIODIC_DROPPED; // refused, server queue full
+} tman_stats_t;
+
+// Mode change status, filled by TMAN_ModeGetStatus()
+typedef struct tman_mode_status {
+    int CURRENT;                // mode in force, -1 before the first switch
+    int PENDING;                // mode waiting for its safe point, -1 if none
+    uint32_t SWITCHES;
+    uint32_t TIMEOUTS;          // requests abandoned after max_wait
+    uint32_t LATENCY_LAST;      // request to switch, in TMAN ticks
+    uint32_t LATENCY_MAX;
+    uint32_t APPLY_MAX;         // dispatcher time spent switching, in microseconds
+} tman_mode_status_t;
 
 void pvTMAN_Task(void *pvParam);
 // Define prototypes (public interface)
 int TMAN_Init(int tick_ms);
+int TMAN_InitMode(int tick_ms, int mode);
+int TMAN_TableBuild(void);
 int TMAN_Close();
-int TMAN_TaskAdd(char taskName[]);
+tman_handle_t TMAN_TaskAdd(char taskName[]);
+tman_handle_t TMAN_JobAdd(char name[], tman_job_fn_t fn, void *arg);
+int TMAN_JobSetBand(tman_handle_t job, int band);
+int TMAN_TaskRemove(tman_handle_t task);
+int TMAN_TaskPause(tman_handle_t task);
+int TMAN_TaskResume(tman_handle_t task);
+tman_handle_t TMAN_TaskGetHandle(char taskName[]);
+const char * TMAN_TaskGetName(tman_handle_t task);
 int TMAN_TaskRegisterAttributes(char taskName[], char attribute[], char value[]);
+int TMAN_TaskRegisterAttributesEx(tman_handle_t task, char attribute[], char value[]);
+int TMAN_TaskAddPrecedence(tman_handle_t task, tman_handle_t predecessor);
+int TMAN_TaskSetLoad(const tman_task_def set[], int count, tman_handle_t handles[]);
+int TMAN_ModeDefine(int mode, const tman_task_def set[], int count);
+int TMAN_ModeSwitch(int mode, int when, int max_wait);
+int TMAN_ModeGetStatus(tman_mode_status_t *out);
+int TMAN_TaskSetOverrunPolicy(tman_handle_t task, int policy, tman_overrun_handler_t handler);
+int TMAN_TaskAborted(tman_handle_t task);
+int TMAN_TaskSetBacklog(tman_handle_t task, int policy, int depth);
+int TMAN_TaskSetBudget(tman_handle_t task, int budget_us, int policy);
+tman_resource_t TMAN_ResourceDeclare(tman_handle_t task, char name[], int cs_us);
+int TMAN_ResourceLock(tman_handle_t task, tman_resource_t resource);
+int TMAN_ResourceUnlock(tman_handle_t task, tman_resource_t resource);
+uint32_t TMAN_TaskGetBlocking(tman_handle_t task);
+int TMAN_TaskSetSporadic(tman_handle_t task, int min_interarrival);
+int TMAN_TaskTrigger(tman_handle_t task);
+int TMAN_TaskTriggerFromISR(tman_handle_t task, BaseType_t *pxHigherPriorityTaskWoken);
+tman_handle_t TMAN_ServerCreate(char name[], int period, int budget_us, UBaseType_t priority, int policy);
+int TMAN_ServerSubmit(tman_handle_t server, tman_job_fn_t fn, void *arg);
+int TMAN_ServerSubmitFromISR(tman_handle_t server, tman_job_fn_t fn, void *arg,
+                             BaseType_t *pxHigherPriorityTaskWoken);
 int TMAN_TaskWaitPeriod(char * pvParameters);
+int TMAN_TaskWaitPeriodEx(tman_handle_t task);
 int * TMAN_TaskStats(char taskName[]);
+int TMAN_TaskStatsEx(tman_handle_t task, tman_stats_t *out);
+int TMAN_StatsSnapshot(tman_handle_t handles[], tman_stats_t out[], int max);
+int TMAN_CheckFeasibility(int policy);
+int TMAN_AssignPriorities(int mode);
+uint64_t TMAN_TaskGetWcrt(tman_handle_t task);
+int TMAN_TaskGetExecTime(tman_handle_t task, uint32_t *min, uint32_t *max, uint32_t *mean);
+#if TMAN_RESPONSE_HISTOGRAM
+int TMAN_TaskGetResponseQuantile(tman_handle_t task, uint32_t basis_points, uint32_t *us);
+#endif
+int TMAN_LogWrite(const char *format, int num_args, tman_log_arg_t a, tman_log_arg_t b,
+                  tman_log_arg_t c, tman_log_arg_t d);
+
+// Context switch hooks, see traceTASK_SWITCHED_IN/OUT in FreeRTOSConfig.h
+void vTMAN_TaskSwitchedIn(void *tag);
+void vTMAN_TaskSwitchedOut(void *tag, long still_ready);
 
 #endif	/* TMAN_H */
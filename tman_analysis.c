@@ -0,0 +1,202 @@
+/* 
+ * File:   tman_analysis.c
+ * Author: André Alves
+ * Author: Eduardo Coelho
+ *
+ * MPLAB X IDE v5.50 + XC32 v3.01
+ *
+ * Target: Digilent chipKIT MAx32 board, host (offline config validator)
+ * 
+ * Overview:
+ *          Schedulability analysis for TMAN task sets: response-time
+ *          analysis for fixed priorities and processor-demand analysis
+ *          for EDF. Plain C, no FreeRTOS dependency.
+ * 
+ */
+
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "tman_analysis.h"
+
+
+static uint64_t prvCeilDiv(uint64_t a, uint64_t b) {
+    return (a + b - 1) / b;
+}
+
+static int prvByPriority(const void *a, const void *b) {
+    const tman_analysis_task *ta = a;
+    const tman_analysis_task *tb = b;
+
+    if (ta->PRIORITY != tb->PRIORITY)
+        return tb->PRIORITY - ta->PRIORITY;
+    return ta->ID - tb->ID;
+}
+
+/* Largest absolute deadline strictly before t, 0 if none */
+static uint64_t prvDeadlineBefore(const tman_analysis_task tasks[], int n, uint64_t t) {
+    uint64_t best = 0;
+
+    for (int i = 0; i < n; i++) {
+        if (t <= tasks[i].DEADLINE)
+            continue;
+        uint64_t d = (t - tasks[i].DEADLINE - 1) / tasks[i].PERIOD * tasks[i].PERIOD + tasks[i].DEADLINE;
+        if (d > best)
+            best = d;
+    }
+    return best;
+}
+
+/* Processor demand: work of the jobs released and due within [0, t] */
+static uint64_t prvDemand(const tman_analysis_task tasks[], int n, uint64_t t) {
+    uint64_t h = 0;
+
+    for (int i = 0; i < n; i++) {
+        if (t >= tasks[i].DEADLINE)
+            h += ((t - tasks[i].DEADLINE) / tasks[i].PERIOD + 1) * tasks[i].WCET;
+    }
+    return h;
+}
+
+/********************************************************************
+ * Function: 	TMAN_AnalysisResponse()
+ * Precondition: PERIOD > 0 for every task
+ * Input: 		 tasks, number of tasks, index of the task to analyse
+ * Returns:      Worst-case response time of tasks[i], or
+ *               TMAN_ANALYSIS_UNBOUNDED when it misses its deadline.
+ * Side Effects:	 
+ * Overview:     Response-time analysis of one task under preemptive
+ *               fixed priorities: every other task with PRIORITY >=
+ *               its own interferes, and one lower priority critical
+ *               section (BLOCKING) can delay it once.
+ *		
+ * Note:		 	Deadlines may exceed periods, every job of the level-i
+ *               busy period is checked. The array is not reordered, so
+ *               priority assignment can call it with trial priorities.
+ * 
+ ********************************************************************/
+
+uint64_t TMAN_AnalysisResponse(const tman_analysis_task tasks[], int n, int i) {
+
+    const tman_analysis_task *task = &tasks[i];
+    uint64_t worst = 0;
+    uint64_t w = task->BLOCKING + task->WCET;
+
+    // Job q of the level-i busy period
+    for (uint64_t q = 0; ; q++) {
+        uint64_t prev;
+
+        if (w < task->BLOCKING + (q + 1) * task->WCET)
+            w = task->BLOCKING + (q + 1) * task->WCET;
+
+        do {
+            prev = w;
+            w = task->BLOCKING + (q + 1) * task->WCET;
+            for (int j = 0; j < n; j++) {
+                if (j != i && tasks[j].PRIORITY >= task->PRIORITY)
+                    w += prvCeilDiv(prev, tasks[j].PERIOD) * tasks[j].WCET;
+            }
+        } while (w != prev && w - q * task->PERIOD <= task->DEADLINE);
+
+        if (w - q * task->PERIOD > worst)
+            worst = w - q * task->PERIOD;
+
+        // Deadline miss, or the busy period ends with this job
+        if (worst > task->DEADLINE || w <= (q + 1) * task->PERIOD)
+            break;
+    }
+
+    return worst > task->DEADLINE ? TMAN_ANALYSIS_UNBOUNDED : worst;
+}
+
+/********************************************************************
+ * Function: 	TMAN_AnalysisRTA()
+ * Precondition: PERIOD > 0 for every task
+ * Input: 		 tasks, number of tasks
+ * Returns:      Number of tasks whose response time exceeds their
+ *               deadline, 0 if the set is schedulable.
+ * Side Effects:	 tasks is sorted by decreasing priority.
+ * Overview:     Exact response-time analysis for preemptive fixed
+ *               priorities. Fills RESPONSE of every task, or
+ *               TMAN_ANALYSIS_UNBOUNDED when it misses its deadline.
+ *		
+ * Note:		 	Tasks of equal priority interfere with each other
+ *               (FreeRTOS time slicing). Deadlines may exceed periods,
+ *               every job of the level-i busy period is checked.
+ * 
+ ********************************************************************/
+
+int TMAN_AnalysisRTA(tman_analysis_task tasks[], int n) {
+
+    int misses = 0;
+
+    qsort(tasks, n, sizeof(tasks[0]), prvByPriority);
+
+    for (int i = 0; i < n; i++) {
+        tasks[i].RESPONSE = TMAN_AnalysisResponse(tasks, n, i);
+        if (tasks[i].RESPONSE == TMAN_ANALYSIS_UNBOUNDED)
+            misses++;
+    }
+
+    return misses;
+}
+
+/********************************************************************
+ * Function: 	TMAN_AnalysisEDF()
+ * Precondition: PERIOD > 0 for every task
+ * Input: 		 tasks, number of tasks
+ * Returns:      0 if the set is schedulable by preemptive EDF, 1 if not.
+ * Side Effects:	 
+ * Overview:     Processor-demand analysis with the QPA iteration
+ *               (Zhang & Burns): walks the absolute deadlines backwards
+ *               from the end of the synchronous busy period, only
+ *               visiting the points where the demand can exceed t.
+ *		
+ * Note:		 	PRIORITY, ID, RESPONSE and BLOCKING are ignored.
+ * 
+ ********************************************************************/
+
+int TMAN_AnalysisEDF(const tman_analysis_task tasks[], int n) {
+
+    uint64_t d_min = UINT64_MAX;
+    uint64_t w = 0;
+    double utilization = 0;
+
+    for (int i = 0; i < n; i++) {
+        utilization += (double) tasks[i].WCET / tasks[i].PERIOD;
+        w += tasks[i].WCET;
+        if (tasks[i].DEADLINE < d_min)
+            d_min = tasks[i].DEADLINE;
+    }
+
+    if (n == 0)
+        return 0;
+    if (utilization > 1.0)
+        return 1;
+
+    // Synchronous busy period bounds the deadlines to check
+    for (;;) {
+        uint64_t next = 0;
+        for (int i = 0; i < n; i++)
+            next += prvCeilDiv(w, tasks[i].PERIOD) * tasks[i].WCET;
+        if (next == w)
+            break;
+        w = next;
+    }
+
+    uint64_t t = prvDeadlineBefore(tasks, n, w + 1);
+    uint64_t h = prvDemand(tasks, n, t);
+
+    while (h <= t && h > d_min) {
+        if (h < t)
+            t = h;
+        else
+            t = prvDeadlineBefore(tasks, n, t);
+        h = prvDemand(tasks, n, t);
+    }
+
+    return h <= d_min ? 0 : 1;
+}
+
+/***************************************End Of File*************************************/
@@ -0,0 +1,41 @@
+/* 
+ * File:   tman_analysis.h
+ * Author: André Alves
+ * Author: Eduardo Coelho
+ *
+ * MPLAB X IDE v5.50 + XC32 v3.01
+ *
+ * Target: Digilent chipKIT MAx32 board, host (offline config validator)
+ * 
+ * Overview:
+ *          Schedulability analysis for TMAN task sets: response-time
+ *          analysis for fixed priorities and processor-demand analysis
+ *          for EDF. Plain C, no FreeRTOS dependency.
+ * 
+ */
+
+#ifndef TMAN_ANALYSIS_H
+#define	TMAN_ANALYSIS_H
+
+#include <stdint.h>
+
+// Response time of a task that can miss its deadline
+#define TMAN_ANALYSIS_UNBOUNDED         UINT64_MAX
+
+// All times in the same unit (TMAN uses microseconds)
+typedef struct tman_analysis_task {
+    uint64_t PERIOD;
+    uint64_t DEADLINE;
+    uint64_t WCET;
+    uint64_t BLOCKING;          // longest lower priority critical section that can delay it, 0 if none
+    int PRIORITY;               // FreeRTOS priority, higher number -> higher priority
+    int ID;                     // caller's index, the task array is reordered
+    uint64_t RESPONSE;          // out: worst-case response time
+} tman_analysis_task;
+
+// Define prototypes (public interface)
+uint64_t TMAN_AnalysisResponse(const tman_analysis_task tasks[], int n, int i);
+int TMAN_AnalysisRTA(tman_analysis_task tasks[], int n);
+int TMAN_AnalysisEDF(const tman_analysis_task tasks[], int n);
+
+#endif	/* TMAN_ANALYSIS_H */
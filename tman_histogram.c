@@ -0,0 +1,110 @@
+/* 
+ * File:   tman_histogram.c
+ * Author: André Alves
+ * Author: Eduardo Coelho
+ *
+ * MPLAB X IDE v5.50 + XC32 v3.01
+ *
+ * Target: Digilent chipKIT MAx32 board, host
+ * 
+ * Overview:
+ *          Fixed-size log-bucketed histogram for streaming quantile
+ *          estimation (p50, p99, p99.9 ...) in constant memory.
+ *          Plain C, no FreeRTOS dependency.
+ * 
+ */
+
+
+#include <stdint.h>
+
+#include "tman_histogram.h"
+
+
+#define SUB_BUCKETS     (1U << TMAN_HIST_SUB_BITS)
+
+static int prvBucket(uint32_t value) {
+    if (value < SUB_BUCKETS)
+        return value;
+
+    int exponent = 31 - __builtin_clz(value);
+    if (exponent >= TMAN_HIST_MAX_BITS)
+        return TMAN_HIST_BUCKETS - 1;
+
+    int shift = exponent - TMAN_HIST_SUB_BITS;
+    return ((shift + 1) << TMAN_HIST_SUB_BITS) + ((value >> shift) & (SUB_BUCKETS - 1));
+}
+
+/* Midpoint of the values that fall in a bucket */
+static uint32_t prvBucketValue(int bucket) {
+    if (bucket < (int) SUB_BUCKETS)
+        return bucket;
+
+    int shift = (bucket >> TMAN_HIST_SUB_BITS) - 1;
+    uint32_t low = (uint32_t) (SUB_BUCKETS + (bucket & (SUB_BUCKETS - 1))) << shift;
+    return low + ((1U << shift) >> 1);
+}
+
+/********************************************************************
+ * Function: 	TMAN_HistogramAdd()
+ * Precondition: 
+ * Input: 		 histogram, sample value
+ * Returns:      
+ * Side Effects:	 When a bucket would overflow, every count is halved
+ *               so recent samples keep their weight.
+ * Overview:     Record one sample, constant time.
+ *		
+ * Note:		 	Single writer.
+ * 
+ ********************************************************************/
+
+void TMAN_HistogramAdd(tman_histogram *hist, uint32_t value) {
+
+    int bucket = prvBucket(value);
+
+    if (hist->COUNT[bucket] == UINT16_MAX) {
+        hist->TOTAL = 0;
+        for (int i = 0; i < TMAN_HIST_BUCKETS; i++) {
+            hist->COUNT[i] >>= 1;
+            hist->TOTAL += hist->COUNT[i];
+        }
+    }
+
+    hist->COUNT[bucket]++;
+    hist->TOTAL++;
+}
+
+/********************************************************************
+ * Function: 	TMAN_HistogramQuantile()
+ * Precondition: 
+ * Input: 		 histogram, quantile in basis points (p99.9 = 9990)
+ * Returns:      Estimated quantile, 0 if the histogram is empty.
+ * Side Effects:	 
+ * Overview:     Nearest-rank quantile, reported as the midpoint of the
+ *               bucket holding that rank.
+ *		
+ * Note:		 	
+ * 
+ ********************************************************************/
+
+uint32_t TMAN_HistogramQuantile(const tman_histogram *hist, uint32_t basis_points) {
+
+    uint32_t total = hist->TOTAL;
+    if (total == 0)
+        return 0;
+
+    // Rank of the sample, 1-based, rounded up
+    uint32_t rank = ((uint64_t) total * basis_points + 9999) / 10000;
+    if (rank == 0)
+        rank = 1;
+
+    uint32_t seen = 0;
+    for (int i = 0; i < TMAN_HIST_BUCKETS; i++) {
+        seen += hist->COUNT[i];
+        if (seen >= rank)
+            return prvBucketValue(i);
+    }
+
+    return prvBucketValue(TMAN_HIST_BUCKETS - 1);
+}
+
+/***************************************End Of File*************************************/
@@ -0,0 +1,38 @@
+/* 
+ * File:   tman_histogram.h
+ * Author: André Alves
+ * Author: Eduardo Coelho
+ *
+ * MPLAB X IDE v5.50 + XC32 v3.01
+ *
+ * Target: Digilent chipKIT MAx32 board, host
+ * 
+ * Overview:
+ *          Fixed-size log-bucketed histogram for streaming quantile
+ *          estimation (p50, p99, p99.9 ...) in constant memory.
+ *          Plain C, no FreeRTOS dependency.
+ * 
+ */
+
+#ifndef TMAN_HISTOGRAM_H
+#define	TMAN_HISTOGRAM_H
+
+#include <stdint.h>
+
+// Each power of two is split in 2^SUB_BITS buckets: the value reported
+// for a quantile is within 1/2^(SUB_BITS+1) (6.25%) of the true sample.
+#define TMAN_HIST_SUB_BITS              3
+// Values at or above 2^MAX_BITS land in the last bucket
+#define TMAN_HIST_MAX_BITS              24
+#define TMAN_HIST_BUCKETS               ((TMAN_HIST_MAX_BITS - TMAN_HIST_SUB_BITS + 1) << TMAN_HIST_SUB_BITS)
+
+typedef struct tman_histogram {
+    uint16_t COUNT[TMAN_HIST_BUCKETS];
+    uint32_t TOTAL;
+} tman_histogram;
+
+// Define prototypes (public interface)
+void TMAN_HistogramAdd(tman_histogram *hist, uint32_t value);
+uint32_t TMAN_HistogramQuantile(const tman_histogram *hist, uint32_t basis_points);
+
+#endif	/* TMAN_HISTOGRAM_H */
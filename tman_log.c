@@ -0,0 +1,96 @@
+/* 
+ * File:   tman_log.c
+ * Author: André Alves
+ * Author: Eduardo Coelho
+ *
+ * MPLAB X IDE v5.50 + XC32 v3.01
+ *
+ * Target: Digilent chipKIT MAx32 board, host
+ * 
+ * Overview:
+ *          Lock-free buffer of unformatted log messages: format string
+ *          pointer, timestamp and raw arguments. Formatting is left to
+ *          the reader. Plain C, no FreeRTOS dependency.
+ * 
+ */
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tman_log.h"
+#include "tman_ring.h"
+
+
+#if (TMAN_LOG_SIZE & (TMAN_LOG_SIZE - 1)) != 0
+#error "TMAN_LOG_SIZE must be a power of two"
+#endif
+
+TMAN_RING_DEFINE(log_ring, tman_log_record, TMAN_LOG_SIZE);
+
+/********************************************************************
+ * Function: 	TMAN_LogPut()
+ * Precondition: 
+ * Input: 		 timestamp, format, number of arguments, arguments
+ * Returns:      0 if queued, -1 if the buffer was full (dropped).
+ * Side Effects:	 
+ * Overview:     Queue one message without formatting it: a few word
+ *               copies, whatever the format.
+ *		
+ * Note:		 	Lock-free, callable from any task or ISR.
+ * 
+ ********************************************************************/
+
+int TMAN_LogPut(uint32_t stamp, const char *format, int num_args,
+                tman_log_arg_t a, tman_log_arg_t b, tman_log_arg_t c, tman_log_arg_t d) {
+
+    uint32_t pos;
+    tman_log_record *record = TMAN_RingReserve(&log_ring, &pos);
+
+    if (record == NULL)
+        return -1;
+    record->FORMAT = format;
+    record->STAMP = stamp;
+    record->NUM_ARGS = num_args;
+    record->ARGS[0] = a;
+    record->ARGS[1] = b;
+    record->ARGS[2] = c;
+    record->ARGS[3] = d;
+    TMAN_RingPublish(&log_ring, pos);
+
+    return 0;
+}
+
+/********************************************************************
+ * Function: 	TMAN_LogGet()
+ * Precondition: Single reader
+ * Input: 		 record to fill
+ * Returns:      1 if a message was taken, 0 if none is ready.
+ * Side Effects:	 
+ * Overview:     Take the oldest message.
+ *		
+ * Note:		 	
+ * 
+ ********************************************************************/
+
+int TMAN_LogGet(tman_log_record *out) {
+    return TMAN_RingTake(&log_ring, out);
+}
+
+/********************************************************************
+ * Function: 	TMAN_LogDropped()
+ * Precondition: 
+ * Input: 		
+ * Returns:      Messages lost because the buffer was full.
+ * Side Effects:	 
+ * Overview:     
+ *		
+ * Note:		 	
+ * 
+ ********************************************************************/
+
+uint32_t TMAN_LogDropped(void) {
+    return log_ring.DROPPED;
+}
+
+/***************************************End Of File*************************************/
@@ -0,0 +1,46 @@
+/* 
+ * File:   tman_log.h
+ * Author: André Alves
+ * Author: Eduardo Coelho
+ *
+ * MPLAB X IDE v5.50 + XC32 v3.01
+ *
+ * Target: Digilent chipKIT MAx32 board, host
+ * 
+ * Overview:
+ *          Lock-free buffer of unformatted log messages: format string
+ *          pointer, timestamp and raw arguments. Formatting is left to
+ *          the reader. Plain C, no FreeRTOS dependency.
+ * 
+ */
+
+#ifndef TMAN_LOG_H
+#define	TMAN_LOG_H
+
+#include <stdint.h>
+
+// Messages held by the buffer, a power of two
+#ifndef TMAN_LOG_SIZE
+#define TMAN_LOG_SIZE                   32
+#endif
+
+#define TMAN_LOG_MAX_ARGS               4
+
+// One argument: an integer, a char or a pointer (e.g. to a string that
+// outlives the message). One word on the PIC32.
+typedef uintptr_t tman_log_arg_t;
+
+typedef struct tman_log_record {
+    const char *FORMAT;         // must outlive the message, e.g. a literal
+    uint32_t STAMP;
+    uint8_t NUM_ARGS;
+    tman_log_arg_t ARGS[TMAN_LOG_MAX_ARGS];
+} tman_log_record;
+
+// Define prototypes (public interface)
+int TMAN_LogPut(uint32_t stamp, const char *format, int num_args,
+                tman_log_arg_t a, tman_log_arg_t b, tman_log_arg_t c, tman_log_arg_t d);
+int TMAN_LogGet(tman_log_record *out);
+uint32_t TMAN_LogDropped(void);
+
+#endif	/* TMAN_LOG_H */
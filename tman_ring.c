@@ -0,0 +1,103 @@
+/* 
+ * File:   tman_ring.c
+ * Author: André Alves
+ * Author: Eduardo Coelho
+ *
+ * MPLAB X IDE v5.50 + XC32 v3.01
+ *
+ * Target: Digilent chipKIT MAx32 board, host
+ * 
+ * Overview:
+ *          Lock-free ring of fixed-size records shared by the trace and
+ *          the log. Any number of writers (tasks, kernel hooks, ISRs),
+ *          one reader. Plain C, no FreeRTOS dependency.
+ * 
+ */
+
+
+#include <stdint.h>
+#include <string.h>
+
+#include "tman_ring.h"
+
+
+/********************************************************************
+ * Function: 	TMAN_RingReserve()
+ * Precondition: 
+ * Input: 		 ring, position to fill
+ * Returns:      The record to write, NULL if the ring was full (the
+ *               record is counted as dropped).
+ * Side Effects:	 
+ * Overview:     Reserve the next position with a compare-and-swap.
+ *               The caller writes the record, then hands the position
+ *               to TMAN_RingPublish().
+ *		
+ * Note:		 	Lock-free, interrupts stay enabled: safe from tasks,
+ *               the context switch hooks and ISRs.
+ * 
+ ********************************************************************/
+
+void *TMAN_RingReserve(tman_ring *ring, uint32_t *pos) {
+
+    uint32_t head;
+
+    do {
+        head = ring->HEAD;
+        if (head - ring->TAIL > ring->MASK) {
+            __sync_fetch_and_add(&ring->DROPPED, 1);
+            return NULL;
+        }
+    } while (!__sync_bool_compare_and_swap(&ring->HEAD, head, head + 1));
+
+    *pos = head;
+    return (char *) ring->RECORDS + (head & ring->MASK) * ring->RECORD_SIZE;
+}
+
+/********************************************************************
+ * Function: 	TMAN_RingPublish()
+ * Precondition: pos reserved by TMAN_RingReserve(), record written
+ * Input: 		 ring, reserved position
+ * Returns:      
+ * Side Effects:	 
+ * Overview:     Make the record visible to the reader through the slot
+ *               sequence number.
+ *		
+ * Note:		 	
+ * 
+ ********************************************************************/
+
+void TMAN_RingPublish(tman_ring *ring, uint32_t pos) {
+
+    __sync_synchronize();
+    ring->SEQ[pos & ring->MASK] = pos + 1;
+}
+
+/********************************************************************
+ * Function: 	TMAN_RingTake()
+ * Precondition: Single reader
+ * Input: 		 ring, record to fill
+ * Returns:      1 if a record was taken, 0 if none is ready.
+ * Side Effects:	 
+ * Overview:     Copy out the oldest record. Stops at a slot that is
+ *               reserved but not yet published, it is taken next call.
+ *		
+ * Note:		 	
+ * 
+ ********************************************************************/
+
+int TMAN_RingTake(tman_ring *ring, void *out) {
+
+    uint32_t pos = ring->TAIL;
+
+    if (pos == ring->HEAD || ring->SEQ[pos & ring->MASK] != pos + 1)
+        return 0;
+    __sync_synchronize();
+
+    memcpy(out, (char *) ring->RECORDS + (pos & ring->MASK) * ring->RECORD_SIZE, ring->RECORD_SIZE);
+    __sync_synchronize();
+    ring->TAIL = pos + 1;
+
+    return 1;
+}
+
+/***************************************End Of File*************************************/
@@ -0,0 +1,44 @@
+/* 
+ * File:   tman_ring.h
+ * Author: André Alves
+ * Author: Eduardo Coelho
+ *
+ * MPLAB X IDE v5.50 + XC32 v3.01
+ *
+ * Target: Digilent chipKIT MAx32 board, host
+ * 
+ * Overview:
+ *          Lock-free ring of fixed-size records shared by the trace and
+ *          the log. Any number of writers (tasks, kernel hooks, ISRs),
+ *          one reader. Plain C, no FreeRTOS dependency.
+ * 
+ */
+
+#ifndef TMAN_RING_H
+#define	TMAN_RING_H
+
+#include <stdint.h>
+
+/* A slot is readable once SEQ[slot] == its ring position + 1 */
+typedef struct tman_ring {
+    volatile uint32_t *SEQ;     // one sequence number per slot
+    void *RECORDS;
+    uint32_t MASK;              // slots - 1, slots a power of two
+    uint32_t RECORD_SIZE;
+    volatile uint32_t HEAD;     // next position to reserve
+    volatile uint32_t TAIL;     // next position to read
+    volatile uint32_t DROPPED;
+} tman_ring;
+
+// Static ring of size records of type, size a power of two
+#define TMAN_RING_DEFINE(name, type, size) \
+    static volatile uint32_t name##_seq[size]; \
+    static type name##_records[size]; \
+    static tman_ring name = { name##_seq, name##_records, (size) - 1, sizeof (type), 0, 0, 0 }
+
+// Define prototypes (public interface)
+void *TMAN_RingReserve(tman_ring *ring, uint32_t *pos);
+void TMAN_RingPublish(tman_ring *ring, uint32_t pos);
+int TMAN_RingTake(tman_ring *ring, void *out);
+
+#endif	/* TMAN_RING_H */
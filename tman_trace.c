@@ -0,0 +1,92 @@
+/* 
+ * File:   tman_trace.c
+ * Author: André Alves
+ * Author: Eduardo Coelho
+ *
+ * MPLAB X IDE v5.50 + XC32 v3.01
+ *
+ * Target: Digilent chipKIT MAx32 board, host
+ * 
+ * Overview:
+ *          Lock-free ring buffer of fixed-size binary scheduling events.
+ *          Any number of writers (tasks, kernel hooks, ISRs), one reader.
+ *          Plain C, no FreeRTOS dependency.
+ * 
+ */
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tman_trace.h"
+#include "tman_ring.h"
+
+
+#if (TMAN_TRACE_SIZE & (TMAN_TRACE_SIZE - 1)) != 0
+#error "TMAN_TRACE_SIZE must be a power of two"
+#endif
+
+TMAN_RING_DEFINE(trace_ring, tman_trace_record, TMAN_TRACE_SIZE);
+
+/********************************************************************
+ * Function: 	TMAN_TraceWrite()
+ * Precondition: 
+ * Input: 		 timestamp, event code, task slot, event argument
+ * Returns:      0 if recorded, -1 if the ring was full (dropped).
+ * Side Effects:	 
+ * Overview:     Append one record, see TMAN_RingReserve().
+ *		
+ * Note:		 	Lock-free, interrupts stay enabled: safe from tasks,
+ *               the context switch hooks and ISRs.
+ * 
+ ********************************************************************/
+
+int TMAN_TraceWrite(uint32_t stamp, int event, int task, int arg) {
+
+    uint32_t pos;
+    tman_trace_record *record = TMAN_RingReserve(&trace_ring, &pos);
+
+    if (record == NULL)
+        return -1;
+    record->STAMP = stamp;
+    record->TASK = task;
+    record->EVENT = event;
+    record->ARG = arg;
+    TMAN_RingPublish(&trace_ring, pos);
+
+    return 0;
+}
+
+/********************************************************************
+ * Function: 	TMAN_TraceRead()
+ * Precondition: Single reader
+ * Input: 		 record to fill
+ * Returns:      1 if a record was read, 0 if none is ready.
+ * Side Effects:	 
+ * Overview:     Take the oldest record, see TMAN_RingTake().
+ *		
+ * Note:		 	
+ * 
+ ********************************************************************/
+
+int TMAN_TraceRead(tman_trace_record *out) {
+    return TMAN_RingTake(&trace_ring, out);
+}
+
+/********************************************************************
+ * Function: 	TMAN_TraceDropped()
+ * Precondition: 
+ * Input: 		
+ * Returns:      Records lost because the ring was full.
+ * Side Effects:	 
+ * Overview:     
+ *		
+ * Note:		 	
+ * 
+ ********************************************************************/
+
+uint32_t TMAN_TraceDropped(void) {
+    return trace_ring.DROPPED;
+}
+
+/***************************************End Of File*************************************/
@@ -0,0 +1,50 @@
+/* 
+ * File:   tman_trace.h
+ * Author: André Alves
+ * Author: Eduardo Coelho
+ *
+ * MPLAB X IDE v5.50 + XC32 v3.01
+ *
+ * Target: Digilent chipKIT MAx32 board, host
+ * 
+ * Overview:
+ *          Lock-free ring buffer of fixed-size binary scheduling events.
+ *          Any number of writers (tasks, kernel hooks, ISRs), one reader.
+ *          Plain C, no FreeRTOS dependency.
+ * 
+ */
+
+#ifndef TMAN_TRACE_H
+#define	TMAN_TRACE_H
+
+#include <stdint.h>
+
+// Records held by the ring, a power of two
+#ifndef TMAN_TRACE_SIZE
+#define TMAN_TRACE_SIZE                 256
+#endif
+
+// Event codes
+#define TMAN_TRACE_ADD                  0x01    // task added to TMAN
+#define TMAN_TRACE_RELEASE              0x02    // job released by the dispatcher
+#define TMAN_TRACE_START                0x03    // job starts (precedence satisfied)
+#define TMAN_TRACE_COMPLETE             0x04    // job reached TMAN_TaskWaitPeriod()
+#define TMAN_TRACE_DEADLINE_MISS        0x05    // job still pending at its deadline
+#define TMAN_TRACE_PRECEDENCE_WAIT      0x06    // job waits for its predecessors
+#define TMAN_TRACE_PREEMPT              0x07    // running job switched out, still ready
+#define TMAN_TRACE_RESUME               0x08    // preempted or blocked job switched back in
+#define TMAN_TRACE_BLOCK                0x09    // running job blocked mid-job (delay, queue, ...)
+
+typedef struct tman_trace_record {
+    uint32_t STAMP;             // core timer count
+    uint16_t TASK;              // TMAN task slot
+    uint8_t EVENT;
+    uint8_t ARG;
+} tman_trace_record;
+
+// Define prototypes (public interface)
+int TMAN_TraceWrite(uint32_t stamp, int event, int task, int arg);
+int TMAN_TraceRead(tman_trace_record *out);
+uint32_t TMAN_TraceDropped(void);
+
+#endif	/* TMAN_TRACE_H */
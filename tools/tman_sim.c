@@ -0,0 +1,563 @@
+/*
+ * File:   tman_sim.c
+ * Author: André Alves
+ * Author: Eduardo Coelho
+ *
+ * Target: host (gcc/clang)
+ *   cc -O2 -o tman_sim tools/tman_sim.c tman_histogram.c
+ *
+ * Overview:
+ *          Discrete-event simulator of a TMAN task set in virtual time,
+ *          to validate a configuration before flashing it. Follows the
+ *          TMAN semantics: releases at PHASE + k * PERIOD, counted
+ *          activations with a bounded backlog (TMAN_BACKLOG_DEPTH),
+ *          precedence joins that take one completed job of every
+ *          predecessor, and misses counted at the deadline instant.
+ *          Jobs run preemptively by priority (FreeRTOS), or by earliest
+ *          absolute deadline with -e (TMAN_MODE_EDF). Execution times
+ *          are drawn uniformly between the given bounds. Shared
+ *          resources follow TMAN_ResourceLock(): a job inside a critical
+ *          section runs at the ceiling of the resource.
+ *
+ *   tman_sim [-n hyperperiods] [-s seed] [-b depth] [-o us] [-e] < taskset
+ *
+ *          -o charges the dispatcher that many microseconds per release,
+ *          above every task (measure it with host/tman_bench).
+ *          Exit status 2 if some deadline was missed, 3 if a job was
+ *          blocked by more than one lower priority job or for longer
+ *          than the bound TMAN_TaskGetBlocking() gives.
+ *
+ *          Task set format, one item per line, '#' starts a comment:
+ *   tick <us>                                  TMAN tick (TMAN_Init)
+ *   <name> <priority> <period> <phase> <deadline> <wcet> [<predecessor> | <resource>:<us> ...]
+ *          period, phase and deadline in TMAN ticks, wcet in microseconds
+ *          as <us> or <min>-<max>. <resource>:<us> declares a critical
+ *          section of that length (TMAN_ResourceDeclare()); a job runs
+ *          its sections back to back from a random point of its
+ *          execution. The main_tman.c set:
+ *   tick 200000
+ *   A 4 1 0 1 300
+ *   B 4 1 0 1 300 F
+ *   C 3 3 0 3 300
+ *   ...
+ *
+ *          Not modelled: time slicing between equal priorities (the
+ *          first one ready runs to completion), kernel overhead other
+ *          than -o, nested critical sections. Resources need fixed
+ *          priorities, not -e.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "../tman_histogram.h"
+
+#define MAX_TASKS       64
+#define MAX_PREDS       8
+#define MAX_BACKLOG     64
+#define MAX_USES        4
+#define MAX_RESOURCES   16
+#define TIME_NEVER      UINT64_MAX
+
+typedef struct sim_task {
+    char NAME[16];
+    int PRIORITY;
+    uint64_t PERIOD;            // all times in microseconds
+    uint64_t PHASE;
+    uint64_t DEADLINE;
+    uint32_t WCET_MIN;
+    uint32_t WCET_MAX;
+    char PRED_NAMES[MAX_PREDS][16];
+    int PREDS[MAX_PREDS];
+    int NUM_PREDS;
+    int SUCCS[MAX_TASKS];
+    int NUM_SUCCS;
+    char USE_NAMES[MAX_USES][16];
+    int USES[MAX_USES];         // resources, in the order a job locks them
+    uint32_t CS[MAX_USES];      // critical section lengths
+    int NUM_USES;
+    uint32_t CS_TOTAL;
+    uint64_t BOUND;             // analytic blocking, as TMAN_TaskGetBlocking()
+    int EDGE_TOKENS[MAX_PREDS]; // as in TMAN: completed predecessor jobs not yet consumed
+    int READY_EDGES;
+    int JOIN;                   // complete sets of predecessor jobs
+    uint64_t NEXT_RELEASE;
+    uint64_t QUEUE[MAX_BACKLOG];    // release times of the outstanding jobs
+    int HEAD;
+    int COUNT;
+    int STARTED;                // head job passed its join and got an execution time
+    uint64_t REMAINING;
+    uint64_t DONE;              // executed part of the head job
+    uint64_t CS_START;          // where its critical sections begin
+    uint64_t BLOCKER;           // last job that blocked the head job, 0 if none
+    int BLOCKS;                 // distinct jobs that blocked it
+    uint64_t BLOCKED;           // and for how long
+    int BLOCKS_MAX;
+    uint64_t BLOCKED_MAX;
+    uint64_t READY_AT;          // when the head job became runnable, FIFO among equals
+    uint64_t RELEASES;
+    uint64_t COMPLETED;
+    uint64_t MISSES;
+    uint64_t DROPPED;
+    uint64_t RESPONSE_MIN;
+    uint64_t RESPONSE_MAX;
+    uint64_t RESPONSE_SUM;
+    tman_histogram RESPONSE_HIST;
+} sim_task;
+
+typedef struct sim_resource {
+    char NAME[16];
+    int CEILING;
+} sim_resource;
+
+static sim_task tasks[MAX_TASKS];
+static int num_tasks = 0;
+static sim_resource resources[MAX_RESOURCES];
+static int num_resources = 0;
+static uint64_t tick_us = 1000;
+static int backlog = 4;
+static int edf = 0;
+static uint64_t overhead_us = 0;
+static uint64_t rng_state = 88172645463325252ULL;
+
+static uint64_t rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static uint64_t gcd(uint64_t a, uint64_t b) {
+    while (b != 0) {
+        uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+static int find_task(const char *name) {
+    for (int i = 0; i < num_tasks; i++) {
+        if (strcmp(tasks[i].NAME, name) == 0)
+            return i;
+    }
+    return -1;
+}
+
+/* Parse the task set, returns 0 on error */
+static int read_taskset(FILE *in) {
+    char line[256];
+    int lineno = 0;
+
+    while (fgets(line, sizeof(line), in) != NULL) {
+        char *fields[6 + MAX_PREDS + MAX_USES];
+        int n = 0;
+
+        lineno++;
+        line[strcspn(line, "#\r\n")] = '\0';
+        for (char *tok = strtok(line, " \t,"); tok != NULL && n < 6 + MAX_PREDS + MAX_USES; tok = strtok(NULL, " \t,"))
+            fields[n++] = tok;
+        if (n == 0)
+            continue;
+
+        if (strcmp(fields[0], "tick") == 0 && n == 2) {
+            tick_us = strtoull(fields[1], NULL, 10);
+            continue;
+        }
+        if (n < 6 || num_tasks == MAX_TASKS) {
+            fprintf(stderr, "line %d: expected <name> <priority> <period> <phase> <deadline> <wcet>\n", lineno);
+            return 0;
+        }
+
+        sim_task *task = &tasks[num_tasks++];
+        strncpy(task->NAME, fields[0], sizeof(task->NAME) - 1);
+        task->PRIORITY = atoi(fields[1]);
+        task->PERIOD = strtoull(fields[2], NULL, 10);
+        task->PHASE = strtoull(fields[3], NULL, 10);
+        task->DEADLINE = strtoull(fields[4], NULL, 10);
+        char *dash = strchr(fields[5], '-');
+        task->WCET_MIN = strtoul(fields[5], NULL, 10);
+        task->WCET_MAX = dash != NULL ? strtoul(dash + 1, NULL, 10) : task->WCET_MIN;
+        for (int k = 6; k < n; k++) {
+            char *colon = strchr(fields[k], ':');
+            if (colon == NULL) {
+                if (task->NUM_PREDS == MAX_PREDS)
+                    break;
+                strncpy(task->PRED_NAMES[task->NUM_PREDS++], fields[k], 15);
+            } else if (task->NUM_USES < MAX_USES) {
+                *colon = '\0';
+                strncpy(task->USE_NAMES[task->NUM_USES], fields[k], 15);
+                task->CS[task->NUM_USES] = strtoul(colon + 1, NULL, 10);
+                task->CS_TOTAL += task->CS[task->NUM_USES++];
+            }
+        }
+
+        if (task->PERIOD == 0 || task->WCET_MAX < task->WCET_MIN) {
+            fprintf(stderr, "line %d: zero period or wcet min > max\n", lineno);
+            return 0;
+        }
+        if (task->WCET_MIN < task->CS_TOTAL) {
+            fprintf(stderr, "line %d: critical sections longer than the wcet\n", lineno);
+            return 0;
+        }
+        // As TMAN_TaskRegisterAttributes(): DEADLINE defaults to PERIOD
+        if (task->DEADLINE == 0)
+            task->DEADLINE = task->PERIOD;
+    }
+
+    // Resolve predecessors, and convert ticks to microseconds
+    for (int i = 0; i < num_tasks; i++) {
+        sim_task *task = &tasks[i];
+        for (int k = 0; k < task->NUM_PREDS; k++) {
+            int pred = find_task(task->PRED_NAMES[k]);
+            if (pred < 0 || pred == i) {
+                fprintf(stderr, "%s: bad predecessor %s\n", task->NAME, task->PRED_NAMES[k]);
+                return 0;
+            }
+            task->PREDS[k] = pred;
+            tasks[pred].SUCCS[tasks[pred].NUM_SUCCS++] = i;
+        }
+        task->PERIOD *= tick_us;
+        task->PHASE *= tick_us;
+        task->DEADLINE *= tick_us;
+        task->NEXT_RELEASE = task->PHASE;
+
+        // Resources, ceilings from the priorities of their users
+        for (int k = 0; k < task->NUM_USES; k++) {
+            int r = 0;
+            while (r < num_resources && strcmp(resources[r].NAME, task->USE_NAMES[k]) != 0)
+                r++;
+            if (r == MAX_RESOURCES || task->CS[k] == 0) {
+                fprintf(stderr, "%s: too many resources or empty critical section\n", task->NAME);
+                return 0;
+            }
+            if (r == num_resources) {
+                strcpy(resources[r].NAME, task->USE_NAMES[k]);
+                resources[r].CEILING = task->PRIORITY;
+                num_resources++;
+            }
+            if (task->PRIORITY > resources[r].CEILING)
+                resources[r].CEILING = task->PRIORITY;
+            task->USES[k] = r;
+        }
+    }
+
+    // Longest lower priority critical section on a resource whose ceiling
+    // reaches the task
+    for (int i = 0; i < num_tasks; i++) {
+        for (int j = 0; j < num_tasks; j++) {
+            if (tasks[j].PRIORITY >= tasks[i].PRIORITY)
+                continue;
+            for (int k = 0; k < tasks[j].NUM_USES; k++) {
+                if (resources[tasks[j].USES[k]].CEILING >= tasks[i].PRIORITY && tasks[j].CS[k] > tasks[i].BOUND)
+                    tasks[i].BOUND = tasks[j].CS[k];
+            }
+        }
+    }
+
+    return num_tasks > 0;
+}
+
+static void release(sim_task *task, uint64_t now) {
+    if (task->COUNT == backlog) {
+        task->DROPPED++;
+        return;
+    }
+    task->QUEUE[(task->HEAD + task->COUNT) % MAX_BACKLOG] = task->NEXT_RELEASE;
+    if (task->COUNT++ == 0)
+        task->READY_AT = now;
+    task->RELEASES++;
+}
+
+/* Can the head job run? Starting it takes one join */
+static int runnable(const sim_task *task) {
+    return task->COUNT > 0 && (task->STARTED || task->NUM_PREDS == 0 || task->JOIN > 0);
+}
+
+/* Priority of the head job: the ceiling of the resource it holds, if
+ * above its own. It holds one while strictly inside a critical section
+ * (at the start it has not run the lock yet). */
+static int priority_of(const sim_task *task) {
+    uint64_t edge = task->CS_START;
+
+    if (!task->STARTED)
+        return task->PRIORITY;
+    for (int k = 0; k < task->NUM_USES; k++) {
+        if (task->DONE > edge && task->DONE < edge + task->CS[k])
+            return resources[task->USES[k]].CEILING > task->PRIORITY
+                    ? resources[task->USES[k]].CEILING : task->PRIORITY;
+        edge += task->CS[k];
+    }
+    return task->PRIORITY;
+}
+
+/* Execution left until the head job enters or leaves a critical section */
+static uint64_t next_edge(const sim_task *task) {
+    uint64_t edge = task->CS_START;
+
+    for (int k = 0; k <= task->NUM_USES; k++) {
+        if (edge > task->DONE)
+            return edge - task->DONE;
+        if (k < task->NUM_USES)
+            edge += task->CS[k];
+    }
+    return TIME_NEVER;
+}
+
+static int before(const sim_task *a, const sim_task *b) {
+    if (edf) {
+        uint64_t da = a->QUEUE[a->HEAD] + a->DEADLINE;
+        uint64_t db = b->QUEUE[b->HEAD] + b->DEADLINE;
+        if (da != db)
+            return da < db;
+    } else if (priority_of(a) != priority_of(b)) {
+        return priority_of(a) > priority_of(b);
+    }
+    return a->READY_AT < b->READY_AT;
+}
+
+static sim_task *pick(void) {
+    sim_task *best = NULL;
+
+    for (int i = 0; i < num_tasks; i++) {
+        if (runnable(&tasks[i]) && (best == NULL || before(&tasks[i], best)))
+            best = &tasks[i];
+    }
+    return best;
+}
+
+/* Runnable jobs of higher priority than the running one wait for it:
+ * blocked, counted once per distinct blocking job */
+static void account_blocking(const sim_task *running, uint64_t run) {
+    uint64_t job = (running->COMPLETED << 6 | (uint64_t) (running - tasks)) + 1;
+
+    for (int i = 0; i < num_tasks; i++) {
+        sim_task *task = &tasks[i];
+        if (task->PRIORITY <= running->PRIORITY || !runnable(task))
+            continue;
+        if (task->BLOCKER != job) {
+            task->BLOCKER = job;
+            task->BLOCKS++;
+        }
+        task->BLOCKED += run;
+    }
+}
+
+/* Histogram quantile clamped to the observed responses: the midpoint of
+ * a bucket can lie past its extreme samples */
+static uint64_t quantile(const sim_task *task, uint32_t basis_points) {
+    uint64_t q = TMAN_HistogramQuantile(&task->RESPONSE_HIST, basis_points);
+
+    if (q > task->RESPONSE_MAX)
+        q = task->RESPONSE_MAX;
+    if (q < task->RESPONSE_MIN)
+        q = task->RESPONSE_MIN;
+    return q;
+}
+
+/* Head job of task completes at now: stats, then one token per dependent
+ * (the join logic of TMAN's prvTMAN_Complete()) */
+static void complete(sim_task *task, uint64_t now) {
+    uint64_t response = now - task->QUEUE[task->HEAD];
+
+    if (task->COMPLETED == 0 || response < task->RESPONSE_MIN)
+        task->RESPONSE_MIN = response;
+    if (response > task->RESPONSE_MAX)
+        task->RESPONSE_MAX = response;
+    task->RESPONSE_SUM += response;
+    TMAN_HistogramAdd(&task->RESPONSE_HIST, response > UINT32_MAX ? UINT32_MAX : response);
+    task->COMPLETED++;
+    if (response > task->DEADLINE)
+        task->MISSES++;
+    if (task->BLOCKS > task->BLOCKS_MAX)
+        task->BLOCKS_MAX = task->BLOCKS;
+    if (task->BLOCKED > task->BLOCKED_MAX)
+        task->BLOCKED_MAX = task->BLOCKED;
+    task->BLOCKER = 0;
+    task->BLOCKS = 0;
+    task->BLOCKED = 0;
+
+    task->HEAD = (task->HEAD + 1) % MAX_BACKLOG;
+    task->COUNT--;
+    task->STARTED = 0;
+    task->READY_AT = now;
+
+    for (int i = 0; i < task->NUM_SUCCS; i++) {
+        sim_task *succ = &tasks[task->SUCCS[i]];
+        for (int k = 0; k < succ->NUM_PREDS; k++) {
+            if (&tasks[succ->PREDS[k]] == task && succ->EDGE_TOKENS[k]++ == 0)
+                succ->READY_EDGES++;
+        }
+        if (succ->READY_EDGES == succ->NUM_PREDS) {
+            for (int k = 0; k < succ->NUM_PREDS; k++) {
+                if (--succ->EDGE_TOKENS[k] == 0)
+                    succ->READY_EDGES--;
+            }
+            succ->JOIN++;
+            if (!succ->STARTED && succ->COUNT > 0 && succ->READY_AT < now)
+                succ->READY_AT = now;
+        }
+    }
+}
+
+static uint64_t simulate(uint64_t end) {
+    uint64_t now = 0;
+    uint64_t dispatcher = 0;    // pending dispatcher work
+    uint64_t jobs = 0;
+
+    while (now < end) {
+        uint64_t next = TIME_NEVER;
+
+        for (int i = 0; i < num_tasks; i++) {
+            sim_task *task = &tasks[i];
+            while (task->NEXT_RELEASE <= now) {
+                release(task, now);
+                dispatcher += overhead_us;
+                task->NEXT_RELEASE += task->PERIOD;
+            }
+            if (task->NEXT_RELEASE < next)
+                next = task->NEXT_RELEASE;
+        }
+        if (next > end)
+            next = end;
+
+        // The dispatcher runs above every task
+        if (dispatcher > 0) {
+            uint64_t run = dispatcher < next - now ? dispatcher : next - now;
+            dispatcher -= run;
+            now += run;
+            continue;
+        }
+
+        sim_task *task = pick();
+        if (task == NULL) {
+            now = next;
+            continue;
+        }
+
+        if (!task->STARTED) {
+            if (task->NUM_PREDS > 0)
+                task->JOIN--;
+            task->STARTED = 1;
+            task->REMAINING = task->WCET_MIN;
+            if (task->WCET_MAX > task->WCET_MIN)
+                task->REMAINING += rng_next() % (task->WCET_MAX - task->WCET_MIN + 1);
+            task->DONE = 0;
+            task->CS_START = 0;
+            if (task->NUM_USES > 0)
+                task->CS_START = rng_next() % (task->REMAINING - task->CS_TOTAL + 1);
+        }
+
+        // Run up to the next release, completion or critical section edge
+        uint64_t run = next - now;
+        if (task->REMAINING < run)
+            run = task->REMAINING;
+        if (next_edge(task) < run)
+            run = next_edge(task);
+        if (!edf)
+            account_blocking(task, run);
+        now += run;
+        task->DONE += run;
+        task->REMAINING -= run;
+        if (task->REMAINING == 0) {
+            complete(task, now);
+            jobs++;
+        }
+    }
+
+    // Jobs still pending past their deadline at the end count as missed
+    for (int i = 0; i < num_tasks; i++) {
+        sim_task *task = &tasks[i];
+        for (int k = 0; k < task->COUNT; k++) {
+            if (task->QUEUE[(task->HEAD + k) % MAX_BACKLOG] + task->DEADLINE < end)
+                task->MISSES++;
+        }
+    }
+
+    return jobs;
+}
+
+int main(int argc, char *argv[]) {
+    uint64_t hyperperiods = 1000;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-e") == 0)
+            edf = 1;
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            hyperperiods = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+            rng_state = strtoull(argv[++i], NULL, 10) | 1;
+        else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc)
+            backlog = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            overhead_us = strtoull(argv[++i], NULL, 10);
+        else {
+            fprintf(stderr, "usage: %s [-n hyperperiods] [-s seed] [-b depth] [-o us] [-e] < taskset\n", argv[0]);
+            return 1;
+        }
+    }
+    if (backlog < 1 || backlog > MAX_BACKLOG) {
+        fprintf(stderr, "backlog depth must be 1..%d\n", MAX_BACKLOG);
+        return 1;
+    }
+
+    if (!read_taskset(stdin))
+        return 1;
+    if (edf && num_resources > 0) {
+        fprintf(stderr, "resources need fixed priorities, drop -e\n");
+        return 1;
+    }
+
+    uint64_t hyperperiod = 1, phase = 0;
+    double utilization = 0;
+    for (int i = 0; i < num_tasks; i++) {
+        hyperperiod = hyperperiod / gcd(hyperperiod, tasks[i].PERIOD) * tasks[i].PERIOD;
+        if (tasks[i].PHASE > phase)
+            phase = tasks[i].PHASE;
+        utilization += (double) tasks[i].WCET_MAX / tasks[i].PERIOD;
+    }
+
+    clock_t start = clock();
+    uint64_t jobs = simulate(phase + hyperperiods * hyperperiod);
+    double seconds = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+    uint64_t misses = 0;
+    int overblocked = 0;
+    printf("%-8s %4s %10s %10s %8s %8s %10s %10s %10s %10s %10s", "task", "prio", "releases",
+           "completed", "misses", "dropped", "resp_min", "resp_avg", "p50", "p99", "resp_max");
+    if (num_resources > 0)
+        printf(" %5s %8s %8s", "blk_n", "blk_max", "B");
+    printf("\n");
+    for (int i = 0; i < num_tasks; i++) {
+        sim_task *task = &tasks[i];
+        printf("%-8s %4d %10llu %10llu %8llu %8llu %10llu %10llu %10llu %10llu %10llu", task->NAME,
+               task->PRIORITY, (unsigned long long) task->RELEASES, (unsigned long long) task->COMPLETED,
+               (unsigned long long) task->MISSES, (unsigned long long) task->DROPPED,
+               (unsigned long long) task->RESPONSE_MIN,
+               (unsigned long long) (task->COMPLETED ? task->RESPONSE_SUM / task->COMPLETED : 0),
+               (unsigned long long) quantile(task, 5000),
+               (unsigned long long) quantile(task, 9900),
+               (unsigned long long) task->RESPONSE_MAX);
+        if (num_resources > 0)
+            printf(" %5d %8llu %8llu", task->BLOCKS_MAX, (unsigned long long) task->BLOCKED_MAX,
+                   (unsigned long long) task->BOUND);
+        printf("\n");
+        misses += task->MISSES;
+        if (task->BLOCKS_MAX > 1 || task->BLOCKED_MAX > task->BOUND)
+            overblocked = 1;
+    }
+    printf("times in us, hyperperiod %llu us, worst-case utilization %.3f\n",
+           (unsigned long long) hyperperiod, utilization);
+
+    fprintf(stderr, "%llu hyperperiods, %llu jobs in %.3f s (%.0f hyperperiods/s)\n",
+            (unsigned long long) hyperperiods, (unsigned long long) jobs, seconds,
+            seconds > 0 ? hyperperiods / seconds : 0);
+
+    if (overblocked)
+        return 3;
+    return misses > 0 ? 2 : 0;
+}
@@ -0,0 +1,242 @@
+/*
+ * File:   tman_trace_decode.c
+ * Author: André Alves
+ * Author: Eduardo Coelho
+ *
+ * Target: host (gcc/clang)
+ *   cc -O2 -o tman_trace_decode tools/tman_trace_decode.c
+ *
+ * Overview:
+ *          Decodes a UART capture of the TMAN trace (TMAN_TRACE = 1) into
+ *          Chrome trace JSON (chrome://tracing, Perfetto) or a text Gantt
+ *          chart. Lines that are not trace lines are ignored, so the raw
+ *          console log can be fed as is.
+ *
+ *   tman_trace_decode < capture.txt > trace.json
+ *   tman_trace_decode -g 1000 < capture.txt     (one column per 1000 us)
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../tman_trace.h"
+
+#define MAX_TASKS       1024
+#define GANTT_COLUMNS   160
+
+typedef struct event {
+    uint64_t STAMP;             // unwrapped timestamp
+    int TASK;
+    int EVENT;
+    int ARG;
+} event;
+
+static char names[MAX_TASKS][32];
+static event *events = NULL;
+static size_t num_events = 0;
+static uint64_t hz = 40000000;
+static unsigned long dropped = 0;
+
+static const char *event_name(int code) {
+    switch (code) {
+        case TMAN_TRACE_ADD:             return "add";
+        case TMAN_TRACE_RELEASE:         return "release";
+        case TMAN_TRACE_START:           return "start";
+        case TMAN_TRACE_COMPLETE:        return "complete";
+        case TMAN_TRACE_DEADLINE_MISS:   return "deadline miss";
+        case TMAN_TRACE_PRECEDENCE_WAIT: return "precedence wait";
+        case TMAN_TRACE_PREEMPT:         return "preempt";
+        case TMAN_TRACE_RESUME:          return "resume";
+        case TMAN_TRACE_BLOCK:           return "block";
+    }
+    return "unknown";
+}
+
+static const char *task_name(int task) {
+    static char fallback[16];
+
+    if (task < MAX_TASKS && names[task][0] != '\0')
+        return names[task];
+    snprintf(fallback, sizeof(fallback), "task %d", task);
+    return fallback;
+}
+
+static double to_us(uint64_t stamp) {
+    return (double) (stamp - events[0].STAMP) * 1e6 / hz;
+}
+
+/* Parse the capture, unwrapping the 32-bit timestamps */
+static void read_capture(FILE *in) {
+    char line[256];
+    size_t capacity = 0;
+    uint64_t epoch = 0;
+    uint32_t last = 0;
+
+    while (fgets(line, sizeof(line), in) != NULL) {
+        char *p = line + strspn(line, " \t\r\n");
+        if (strchr("HNRD", p[0]) == NULL || p[0] == '\0')
+            continue;
+
+        if (p[0] == 'H') {
+            hz = strtoull(p + 1, NULL, 10);
+        } else if (p[0] == 'D') {
+            dropped = strtoul(p + 1, NULL, 10);
+        } else if (p[0] == 'N') {
+            unsigned task;
+            char name[32];
+            if (sscanf(p + 1, "%4x %31s", &task, name) == 2 && task < MAX_TASKS)
+                strcpy(names[task], name);
+        } else {
+            unsigned long stamp;
+            unsigned task, code, arg;
+            if (strlen(p) < 17 || sscanf(p + 1, "%8lx%4x%2x%2x", &stamp, &task, &code, &arg) != 4)
+                continue;
+
+            if (num_events > 0 && (uint32_t) stamp < last)
+                epoch += 1ULL << 32;
+            last = stamp;
+
+            if (num_events == capacity) {
+                capacity = capacity ? 2 * capacity : 1024;
+                events = realloc(events, capacity * sizeof(*events));
+                if (events == NULL) {
+                    perror("realloc");
+                    exit(1);
+                }
+            }
+            events[num_events].STAMP = epoch + stamp;
+            events[num_events].TASK = task;
+            events[num_events].EVENT = code;
+            events[num_events].ARG = arg;
+            num_events++;
+        }
+    }
+}
+
+/* Jobs run between start/resume and preempt/complete: duration events.
+ * Everything else is an instant on the task's row. */
+static void write_chrome(FILE *out) {
+    int first = 1;
+
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (int task = 0; task < MAX_TASKS; task++) {
+        if (names[task][0] == '\0')
+            continue;
+        fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",\n", task, names[task]);
+        first = 0;
+    }
+
+    for (size_t i = 0; i < num_events; i++) {
+        const event *e = &events[i];
+        const char *phase;
+
+        switch (e->EVENT) {
+            case TMAN_TRACE_START:
+            case TMAN_TRACE_RESUME:
+                phase = "B";
+                break;
+            case TMAN_TRACE_COMPLETE:
+            case TMAN_TRACE_PREEMPT:
+            case TMAN_TRACE_BLOCK:
+                phase = "E";
+                break;
+            case TMAN_TRACE_ADD:
+                continue;
+            default:
+                phase = "i";
+        }
+
+        fprintf(out, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%s\",\"pid\":1,\"tid\":%d,\"ts\":%.3f",
+                first ? "" : ",\n", phase[0] == 'i' ? event_name(e->EVENT) : task_name(e->TASK),
+                event_name(e->EVENT), phase, e->TASK, to_us(e->STAMP));
+        if (phase[0] == 'i')
+            fprintf(out, ",\"s\":\"t\",\"args\":{\"arg\":%d}", e->ARG);
+        fprintf(out, "}");
+        first = 0;
+    }
+    fprintf(out, "\n]}\n");
+}
+
+/* One row per task: '#' running, '|' release, '!' deadline miss */
+static void write_gantt(FILE *out, double column_us) {
+    static char rows[MAX_TASKS][GANTT_COLUMNS + 1];
+    static double run_from[MAX_TASKS];
+    int used[MAX_TASKS] = { 0 };
+
+    for (int task = 0; task < MAX_TASKS; task++) {
+        memset(rows[task], '.', GANTT_COLUMNS);
+        rows[task][GANTT_COLUMNS] = '\0';
+        run_from[task] = -1;
+    }
+
+    for (size_t i = 0; i < num_events; i++) {
+        const event *e = &events[i];
+        double t = to_us(e->STAMP);
+        int column = t / column_us;
+
+        if (e->TASK >= MAX_TASKS)
+            continue;
+        used[e->TASK] = 1;
+
+        switch (e->EVENT) {
+            case TMAN_TRACE_START:
+            case TMAN_TRACE_RESUME:
+                run_from[e->TASK] = t;
+                break;
+            case TMAN_TRACE_COMPLETE:
+            case TMAN_TRACE_PREEMPT:
+            case TMAN_TRACE_BLOCK:
+                if (run_from[e->TASK] >= 0) {
+                    for (int c = run_from[e->TASK] / column_us; c <= column && c < GANTT_COLUMNS; c++)
+                        rows[e->TASK][c] = '#';
+                }
+                run_from[e->TASK] = -1;
+                break;
+            case TMAN_TRACE_RELEASE:
+                if (column < GANTT_COLUMNS && rows[e->TASK][column] == '.')
+                    rows[e->TASK][column] = '|';
+                break;
+            case TMAN_TRACE_DEADLINE_MISS:
+                if (column < GANTT_COLUMNS)
+                    rows[e->TASK][column] = '!';
+                break;
+        }
+    }
+
+    fprintf(out, "%.0f us per column\n", column_us);
+    for (int task = 0; task < MAX_TASKS; task++) {
+        if (used[task])
+            fprintf(out, "%-12s %s\n", task_name(task), rows[task]);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    double column_us = 0;
+
+    if (argc == 3 && strcmp(argv[1], "-g") == 0) {
+        column_us = atof(argv[2]);
+    } else if (argc != 1) {
+        fprintf(stderr, "usage: %s [-g us_per_column] < capture\n", argv[0]);
+        return 2;
+    }
+
+    read_capture(stdin);
+    if (num_events == 0) {
+        fprintf(stderr, "no trace records found\n");
+        return 1;
+    }
+    if (dropped > 0)
+        fprintf(stderr, "warning: %lu records were dropped on the target\n", dropped);
+
+    if (column_us > 0)
+        write_gantt(stdout, column_us);
+    else
+        write_chrome(stdout);
+
+    free(events);
+    return 0;
+}